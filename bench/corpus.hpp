@@ -0,0 +1,127 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <random>
+#include <string>
+
+#include <sexpr-cpp/data.hpp>
+
+
+namespace sexpr::bench
+{
+
+// synthetic trees; every generator uses a fixed seed, i.e. the corpora
+// are identical across runs and releases
+struct corpus_size
+{
+    std::size_t depth;
+    std::size_t width;
+    std::size_t atoms;
+    std::size_t records;
+};
+
+constexpr corpus_size full_size{ 100000, 100000, 200000, 20000 };
+constexpr corpus_size smoke_size{ 100, 100, 200, 20 };
+
+
+class corpus_generator
+{
+public:
+    explicit corpus_generator(std::uint64_t seed = 0x5eed)
+        : mRng(seed)
+    {
+    }
+
+    std::string atom(std::size_t minLength, std::size_t maxLength)
+    {
+        static constexpr char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789-_";
+        std::uniform_int_distribution<std::size_t> length(minLength, maxLength);
+        std::uniform_int_distribution<std::size_t> letter(0, sizeof(alphabet) - 2);
+        std::string s(length(mRng), ' ');
+        for (auto &c : s)
+        {
+            c = alphabet[letter(mRng)];
+        }
+        return s;
+    }
+
+    // (((... (x) ...)))
+    node deep(std::size_t depth)
+    {
+        node root;
+        node *current = &root;
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            current->emplace_back(atom(1, 4));
+            current = &current->emplace_back();
+        }
+        return root;
+    }
+
+    // one list with width short atoms
+    node wide(std::size_t width)
+    {
+        node root;
+        root.get_list().reserve(width);
+        for (std::size_t i = 0; i < width; ++i)
+        {
+            root.emplace_back(atom(1, 12));
+        }
+        return root;
+    }
+
+    // few lists, long atoms, some of which need quoting
+    node atom_heavy(std::size_t count)
+    {
+        std::bernoulli_distribution quoted(0.2);
+        node root;
+        for (std::size_t i = 0; i < count; i += 16)
+        {
+            auto &group = root.emplace_back();
+            for (std::size_t j = i; j < count && j < i + 16; ++j)
+            {
+                auto s = atom(16, 96);
+                if (quoted(mRng))
+                {
+                    s[s.size() / 2] = ' ';
+                    s[s.size() / 3] = '"';
+                }
+                group.emplace_back(std::move(s));
+            }
+        }
+        return root;
+    }
+
+    // (record <id> (name <atom>) (tags <atom>...) (pos <x> <y>))...
+    node records(std::size_t count)
+    {
+        std::uniform_int_distribution<int> tags(0, 6);
+        std::uniform_int_distribution<int> coord(-100000, 100000);
+        node root;
+        root.get_list().reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto &rec = root.emplace_back(node{ "record", std::to_string(i) });
+            rec.push_back(node{ "name", atom(4, 24) });
+            auto &t = rec.emplace_back(node{ "tags" });
+            for (int k = tags(mRng); k > 0; --k)
+            {
+                t.emplace_back(atom(2, 8));
+            }
+            rec.push_back(node{ "pos", std::to_string(coord(mRng)), std::to_string(coord(mRng)) });
+        }
+        return root;
+    }
+
+private:
+    std::mt19937_64 mRng;
+};
+
+}
@@ -0,0 +1,355 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <optional>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/diff.hpp>
+#include <sexpr-cpp/hash.hpp>
+#include <sexpr-cpp/tape.hpp>
+#include <sexpr-cpp/parser.hpp>
+#include <sexpr-cpp/emitter.hpp>
+#include <sexpr-cpp/cow_vector.hpp>
+#include <sexpr-cpp/parallel_parser.hpp>
+
+#include "corpus.hpp"
+
+using namespace sexpr;
+using namespace sexpr::bench;
+
+#ifndef SEXPR_CPP_BUILD_TYPE
+#define SEXPR_CPP_BUILD_TYPE "unknown"
+#endif
+
+
+namespace
+{
+// keeps the optimizer from discarding a result
+template< class T >
+inline void keep(const T &value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static const void * volatile sink;
+    sink = &value;
+#endif
+}
+
+struct atom_counter
+{
+    std::size_t atoms = 0;
+
+    void begin_list()
+    {
+    }
+    void end_list()
+    {
+    }
+    void atom(std::string_view, bool)
+    {
+        ++atoms;
+    }
+};
+
+struct options
+{
+    bool smoke = false;
+    double minTime = 0.5;
+    std::string filter;
+    std::string output;
+};
+
+struct result
+{
+    std::string name;
+    std::string corpus;
+    std::size_t iterations;
+    double minNs;
+    double medianNs;
+    std::size_t bytes;
+};
+
+class runner
+{
+public:
+    explicit runner(const options &opts)
+        : mOpts(opts)
+        , mResults()
+    {
+    }
+
+    // runs fn repeatedly for at least the minimum time; setup is
+    // excluded from the measurement and runs before every iteration
+    template< class TSetup, class TFunc >
+    void run(const std::string &name, const std::string &corpus, std::size_t bytes,
+        TSetup setup, TFunc fn)
+    {
+        const auto fullName = name + "/" + corpus;
+        if (!mOpts.filter.empty() && fullName.find(mOpts.filter) == std::string::npos)
+        {
+            return;
+        }
+
+        using clock = std::chrono::steady_clock;
+        std::vector<double> samples;
+        const auto budget = std::chrono::duration<double>(mOpts.smoke ? 0.0 : mOpts.minTime);
+        const auto start = clock::now();
+        do
+        {
+            auto state = setup();
+            const auto t0 = clock::now();
+            fn(state);
+            const auto t1 = clock::now();
+            keep(state);
+            samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+        }
+        while (samples.size() < 3 || clock::now() - start < budget);
+
+        std::sort(samples.begin(), samples.end());
+        mResults.push_back({ name, corpus, samples.size(), samples.front(),
+            samples[samples.size() / 2], bytes });
+        std::cerr << fullName << ": " << samples[samples.size() / 2] / 1e6 << " ms\n";
+    }
+    template< class TFunc >
+    void run(const std::string &name, const std::string &corpus, std::size_t bytes, TFunc fn)
+    {
+        run(name, corpus, bytes, []() { return 0; }, [&fn](int &) { fn(); });
+    }
+
+    void write_json(std::ostream &out) const
+    {
+        out << "{\n  \"context\": {\n"
+            << "    \"library\": \"sexpr-cpp\",\n"
+            << "    \"build_type\": \"" << SEXPR_CPP_BUILD_TYPE << "\",\n"
+            << "    \"compiler\": \"" << compiler() << "\",\n"
+            << "    \"smoke\": " << (mOpts.smoke ? "true" : "false") << "\n"
+            << "  },\n  \"benchmarks\": [";
+        for (std::size_t i = 0; i < mResults.size(); ++i)
+        {
+            const auto &r = mResults[i];
+            out << (i ? ",\n" : "\n")
+                << "    { \"name\": \"" << r.name << "\""
+                << ", \"corpus\": \"" << r.corpus << "\""
+                << ", \"iterations\": " << r.iterations
+                << ", \"min_ns\": " << static_cast<std::uint64_t>(r.minNs)
+                << ", \"median_ns\": " << static_cast<std::uint64_t>(r.medianNs)
+                << ", \"bytes\": " << r.bytes
+                << ", \"bytes_per_second\": "
+                << static_cast<std::uint64_t>(r.medianNs > 0 ? r.bytes * 1e9 / r.medianNs : 0)
+                << " }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+    static std::string compiler()
+    {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    const options &mOpts;
+    std::vector<result> mResults;
+};
+
+
+// copies share their lists; the mutation copies the path to the last atom
+void cow_benchmarks(runner &r, const std::string &corpus, const std::string &text)
+{
+    const auto bytes = text.size();
+    const auto n = parse<cow_node>(text);
+
+    // the copies are released outside of the measurement
+    const auto release = []() { return std::optional<cow_node>(); };
+    r.run("cow_copy", corpus, bytes, release,
+        [&](std::optional<cow_node> &copy) { copy.emplace(n); });
+    r.run("cow_copy_mutate", corpus, bytes, release, [&](std::optional<cow_node> &copy)
+    {
+        cow_node *current = &copy.emplace(n);
+        while (current->is_list() && !current->empty())
+        {
+            current = &current->back();
+        }
+        if (current->is_string())
+        {
+            current->get_string() += "~";
+        }
+    });
+}
+
+void node_benchmarks(runner &r, const std::string &corpus, const node &n)
+{
+    const auto text = to_string(n);
+    const auto bytes = text.size();
+    node other = n;
+    // differs in the last atom only
+    node last = n;
+    {
+        node *current = &last;
+        while (current->is_list() && !current->empty())
+        {
+            current = &current->back();
+        }
+        if (current->is_string())
+        {
+            current->get_string() += "~";
+        }
+        else
+        {
+            current->emplace_back("~");
+        }
+    }
+
+    // the copy is released outside of the measurement, see destroy
+    r.run("copy", corpus, bytes, []() { return std::optional<node>(); },
+        [&](std::optional<node> &copy) { copy.emplace(n); });
+    r.run("destroy", corpus, bytes, [&]() { return node(n); },
+        [](node &victim) { node().swap(victim); });
+    r.run("swap", corpus, bytes, [&]() { return node(n); },
+        [&](node &a) { for (int i = 0; i < 1000; ++i) { a.swap(other); } });
+    r.run("equal", corpus, bytes, [&]() { keep(n == other); });
+    r.run("less", corpus, bytes, [&]() { keep(n < last); });
+    r.run("hash", corpus, bytes, [&]() { keep(hash_value(n)); });
+    r.run("diff", corpus, bytes, [&]() { keep(diff(n, last)); });
+    r.run("iterate", corpus, bytes, [&]()
+    {
+        atom_counter counter;
+        walk_events(n, counter);
+        keep(counter.atoms);
+    });
+    r.run("emit", corpus, bytes, [&]() { keep(to_string(n)); });
+    r.run("parse", corpus, bytes, [&]() { keep(parse(text)); });
+    r.run("parse_tape", corpus, bytes, [&]() { keep(parse_tape(text)); });
+    cow_benchmarks(r, corpus, text);
+}
+
+void record_benchmarks(runner &r, const std::string &corpus, const node &records)
+{
+    std::string text;
+    for (const auto &rec : records)
+    {
+        text += to_string(rec);
+        text += '\n';
+    }
+    const auto bytes = text.size();
+
+    r.run("parse_all", corpus, bytes, [&]() { keep(parse_all(text)); });
+    r.run("parse_all_parallel", corpus, bytes, [&]() { keep(parse_all_parallel(text)); });
+    r.run("construct", corpus, bytes, [&]()
+    {
+        node root;
+        for (const auto &rec : records)
+        {
+            root.push_back(node{ rec[0], rec[1], { "name", rec[2][1] }, rec[3], rec[4] });
+        }
+        keep(root);
+    });
+}
+
+void mutation_benchmarks(runner &r, const std::string &corpus, const node &wide)
+{
+    const auto bytes = wide.size() * sizeof(node);
+    const node value{ "inserted", "value" };
+    r.run("insert_front", corpus, bytes, [&]() { return node(wide); },
+        [&](node &n) { for (int i = 0; i < 100; ++i) { n.insert(n.begin(), value); } });
+    r.run("erase_front", corpus, bytes, [&]() { return node(wide); },
+        [](node &n) { for (int i = 0; i < 100; ++i) { n.erase(n.begin()); } });
+    r.run("resize", corpus, bytes, [&]() { return node(wide); },
+        [&](node &n) { n.resize(n.size() / 2); n.resize(n.size() * 2, value); });
+}
+
+bool parse_options(int argc, char *argv[], options &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--smoke")
+        {
+            opts.smoke = true;
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            opts.filter = argv[++i];
+        }
+        else if (arg == "--min-time" && i + 1 < argc)
+        {
+            opts.minTime = std::stod(argv[++i]);
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            opts.output = argv[++i];
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0]
+                << " [--smoke] [--filter <substring>] [--min-time <seconds>] [--output <file>]\n";
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+
+int main(int argc, char *argv[])
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        return 2;
+    }
+    const auto size = opts.smoke ? smoke_size : full_size;
+
+    runner r(opts);
+    {
+        corpus_generator gen;
+        const auto deep = gen.deep(size.depth);
+        const auto wide = gen.wide(size.width);
+        const auto atoms = gen.atom_heavy(size.atoms);
+        const auto records = gen.records(size.records);
+
+        node_benchmarks(r, "deep", deep);
+        node_benchmarks(r, "wide", wide);
+        node_benchmarks(r, "atom_heavy", atoms);
+        node_benchmarks(r, "records", records);
+        record_benchmarks(r, "records", records);
+        mutation_benchmarks(r, "wide", wide);
+    }
+
+    if (opts.output.empty())
+    {
+        r.write_json(std::cout);
+    }
+    else
+    {
+        std::ofstream out(opts.output);
+        r.write_json(out);
+        if (!out)
+        {
+            std::cerr << "couldn't write " << opts.output << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
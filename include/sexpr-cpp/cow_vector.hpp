@@ -0,0 +1,573 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <memory_resource>
+#include <initializer_list>
+
+#include <sexpr-cpp/data.hpp>
+
+
+namespace sexpr
+{
+
+// vector whose copies share a reference counted buffer until either of
+// them is modified; copies with an equal allocator are O(1).
+//
+// Every non-const member function unshares the buffer first, i.e. only
+// the lists along the path to a modification are copied and their
+// children keep sharing. The reference count is atomic, so copies may be
+// handed to other threads; a single cow_vector still must not be modified
+// concurrently. Like with std::vector, copying the vector invalidates
+// references and iterators which were obtained by non-const access.
+template< class T, class Allocator = std::allocator<T> >
+class cow_vector
+{
+    using storage = std::vector<T, Allocator>;
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    struct rep
+    {
+        std::atomic<std::size_t> refs;
+        storage items;
+
+        template< class... TArgs >
+        explicit rep(TArgs&&... args)
+            : refs(1)
+            , items(std::forward<TArgs>(args)...)
+        {
+        }
+    };
+    using rep_allocator = typename alloc_traits::template rebind_alloc<rep>;
+    using rep_traits = std::allocator_traits<rep_allocator>;
+
+public:
+    static constexpr bool shares_storage = true;
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = T *;
+    using const_iterator = const T *;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    cow_vector() noexcept(noexcept(Allocator()))
+        : mAlloc()
+        , mRep(nullptr)
+    {
+    }
+    explicit cow_vector(const Allocator &alloc) noexcept
+        : mAlloc(alloc)
+        , mRep(nullptr)
+    {
+    }
+    template< class TInputIterator,
+        std::enable_if_t<
+            std::is_base_of<
+                std::input_iterator_tag,
+                typename std::iterator_traits<TInputIterator>::iterator_category
+            >::value, int
+        > = 0
+    >
+    cow_vector(TInputIterator first, TInputIterator last, const Allocator &alloc = Allocator())
+        : mAlloc(alloc)
+        , mRep(nullptr)
+    {
+        if (first != last)
+        {
+            mRep = make_rep(first, last, mAlloc);
+        }
+    }
+    cow_vector(std::initializer_list<T> il, const Allocator &alloc = Allocator())
+        : cow_vector(il.begin(), il.end(), alloc)
+    {
+    }
+
+    cow_vector(const cow_vector &other)
+        : cow_vector(other, alloc_traits::select_on_container_copy_construction(other.mAlloc))
+    {
+    }
+    cow_vector(const cow_vector &other, const Allocator &alloc)
+        : mAlloc(alloc)
+        , mRep(nullptr)
+    {
+        if (mAlloc == other.mAlloc)
+        {
+            share(other.mRep);
+        }
+        else if (!other.empty())
+        {
+            mRep = make_rep(other.mRep->items, mAlloc);
+        }
+    }
+    cow_vector(cow_vector &&other) noexcept
+        : mAlloc(other.mAlloc)
+        , mRep(std::exchange(other.mRep, nullptr))
+    {
+    }
+    cow_vector(cow_vector &&other, const Allocator &alloc)
+        : mAlloc(alloc)
+        , mRep(nullptr)
+    {
+        if (mAlloc == other.mAlloc)
+        {
+            mRep = std::exchange(other.mRep, nullptr);
+        }
+        else if (!other.empty())
+        {
+            mRep = other.unique()
+                ? make_rep(std::move(other.mRep->items), mAlloc)
+                : make_rep(other.mRep->items, mAlloc);
+        }
+    }
+
+    // the new contents are acquired before the old ones are released,
+    // because the source may be one of our elements
+    cow_vector & operator=(const cow_vector &other)
+    {
+        if (this != &other)
+        {
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+            {
+                cow_vector tmp(other, other.mAlloc);
+                release();
+                mAlloc = other.mAlloc;
+                mRep = std::exchange(tmp.mRep, nullptr);
+            }
+            else
+            {
+                cow_vector tmp(other, mAlloc);
+                release();
+                mRep = std::exchange(tmp.mRep, nullptr);
+            }
+        }
+        return *this;
+    }
+    cow_vector & operator=(cow_vector &&other)
+        noexcept(alloc_traits::propagate_on_container_move_assignment::value
+            || alloc_traits::is_always_equal::value)
+    {
+        if (this != &other)
+        {
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                auto alloc = other.mAlloc;
+                auto p = std::exchange(other.mRep, nullptr);
+                release();
+                mAlloc = std::move(alloc);
+                mRep = p;
+            }
+            else
+            {
+                cow_vector tmp(std::move(other), mAlloc);
+                release();
+                mRep = std::exchange(tmp.mRep, nullptr);
+            }
+        }
+        return *this;
+    }
+    cow_vector & operator=(std::initializer_list<T> il)
+    {
+        return *this = cow_vector(il, mAlloc);
+    }
+
+    ~cow_vector()
+    {
+        release();
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return mAlloc;
+    }
+
+    // whether no other vector shares the buffer
+    bool unique() const noexcept
+    {
+        return !mRep || mRep->refs.load(std::memory_order_acquire) == 1;
+    }
+    // number of vectors sharing the buffer; 0 if nothing is allocated
+    std::size_t use_count() const noexcept
+    {
+        return mRep ? mRep->refs.load(std::memory_order_acquire) : 0;
+    }
+
+
+    #pragma region element access
+
+    pointer data()
+    {
+        return mRep ? unshared().data() : nullptr;
+    }
+    const_pointer data() const noexcept
+    {
+        return mRep ? mRep->items.data() : nullptr;
+    }
+
+    reference at(size_type idx)
+    {
+        check_index(idx);
+        return data()[idx];
+    }
+    const_reference at(size_type idx) const
+    {
+        check_index(idx);
+        return data()[idx];
+    }
+    reference operator[](size_type idx)
+    {
+        return data()[idx];
+    }
+    const_reference operator[](size_type idx) const noexcept
+    {
+        return data()[idx];
+    }
+    reference front()
+    {
+        return data()[0];
+    }
+    const_reference front() const noexcept
+    {
+        return data()[0];
+    }
+    reference back()
+    {
+        return data()[size() - 1];
+    }
+    const_reference back() const noexcept
+    {
+        return data()[size() - 1];
+    }
+
+    #pragma endregion
+
+
+    #pragma region iterator methods [begin, end)
+
+    iterator begin()
+    {
+        return data();
+    }
+    const_iterator begin() const noexcept
+    {
+        return data();
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return data();
+    }
+    iterator end()
+    {
+        return data() + size();
+    }
+    const_iterator end() const noexcept
+    {
+        return data() + size();
+    }
+    const_iterator cend() const noexcept
+    {
+        return data() + size();
+    }
+
+    reverse_iterator rbegin()
+    {
+        return reverse_iterator(end());
+    }
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator crbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    reverse_iterator rend()
+    {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    #pragma endregion
+
+
+    bool empty() const noexcept
+    {
+        return !mRep || mRep->items.empty();
+    }
+    size_type size() const noexcept
+    {
+        return mRep ? mRep->items.size() : 0;
+    }
+    size_type max_size() const noexcept
+    {
+        return alloc_traits::max_size(mAlloc);
+    }
+    size_type capacity() const noexcept
+    {
+        return mRep ? mRep->items.capacity() : 0;
+    }
+
+    void reserve(size_type n)
+    {
+        if (n > capacity() || (n > size() && !unique()))
+        {
+            mutable_items(n).reserve(n);
+        }
+    }
+    void shrink_to_fit()
+    {
+        if (unique() && mRep)
+        {
+            mRep->items.shrink_to_fit();
+        }
+    }
+
+    // a shared buffer is merely released
+    void clear() noexcept
+    {
+        if (unique())
+        {
+            if (mRep)
+            {
+                mRep->items.clear();
+            }
+        }
+        else
+        {
+            release();
+        }
+    }
+
+    // positions are converted to offsets first, because they may point
+    // into a shared buffer which is about to be copied
+    iterator insert(const_iterator pos, const T &value)
+    {
+        return emplace(pos, value);
+    }
+    iterator insert(const_iterator pos, T &&value)
+    {
+        return emplace(pos, std::move(value));
+    }
+    iterator insert(const_iterator pos, size_type count, const T &value)
+    {
+        const auto offset = pos - cbegin();
+        auto &items = mutable_items(size() + count);
+        return items.data() + (items.insert(items.cbegin() + offset, count, value) - items.begin());
+    }
+    template< class TInputIterator,
+        std::enable_if_t<
+            std::is_base_of<
+                std::input_iterator_tag,
+                typename std::iterator_traits<TInputIterator>::iterator_category
+            >::value, int
+        > = 0
+    >
+    iterator insert(const_iterator pos, TInputIterator first, TInputIterator last)
+    {
+        const auto offset = pos - cbegin();
+        auto &items = mutable_items(size());
+        return items.data() + (items.insert(items.cbegin() + offset, first, last) - items.begin());
+    }
+    iterator insert(const_iterator pos, std::initializer_list<T> il)
+    {
+        return insert(pos, il.begin(), il.end());
+    }
+    template< class... TArgs >
+    iterator emplace(const_iterator pos, TArgs&&... args)
+    {
+        const auto offset = pos - cbegin();
+        auto &items = mutable_items(size() + 1);
+        return items.data() + (items.emplace(items.cbegin() + offset, std::forward<TArgs>(args)...) - items.begin());
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const auto offset = first - cbegin();
+        const auto count = last - first;
+        auto &items = mutable_items(size());
+        return items.data() + (items.erase(items.cbegin() + offset, items.cbegin() + offset + count) - items.begin());
+    }
+
+    void push_back(const T &value)
+    {
+        emplace_back(value);
+    }
+    void push_back(T &&value)
+    {
+        emplace_back(std::move(value));
+    }
+    template< class... TArgs >
+    reference emplace_back(TArgs&&... args)
+    {
+        return mutable_items(size() + 1).emplace_back(std::forward<TArgs>(args)...);
+    }
+    void pop_back()
+    {
+        mutable_items(size()).pop_back();
+    }
+
+    void resize(size_type count)
+    {
+        if (count != size())
+        {
+            mutable_items(count).resize(count);
+        }
+    }
+    void resize(size_type count, const T &value)
+    {
+        if (count != size())
+        {
+            mutable_items(count).resize(count, value);
+        }
+    }
+
+    void swap(cow_vector &other) noexcept
+    {
+        if constexpr (alloc_traits::propagate_on_container_swap::value)
+        {
+            using std::swap;
+            swap(mAlloc, other.mAlloc);
+        }
+        std::swap(mRep, other.mRep);
+    }
+    friend void swap(cow_vector &lhs, cow_vector &rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+private:
+    void check_index(size_type idx) const
+    {
+        if (idx >= size())
+        {
+            throw std::out_of_range("cow_vector::at() index out of range");
+        }
+    }
+
+    template< class... TArgs >
+    rep * make_rep(TArgs&&... args) const
+    {
+        rep_allocator alloc(mAlloc);
+        auto p = rep_traits::allocate(alloc, 1);
+        try
+        {
+            ::new (static_cast<void *>(p)) rep(std::forward<TArgs>(args)...);
+        }
+        catch (...)
+        {
+            rep_traits::deallocate(alloc, p, 1);
+            throw;
+        }
+        return p;
+    }
+    void destroy_rep(rep *p) const noexcept
+    {
+        rep_allocator alloc(mAlloc);
+        p->~rep();
+        rep_traits::deallocate(alloc, p, 1);
+    }
+
+    void share(rep *p) noexcept
+    {
+        if (p)
+        {
+            p->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        mRep = p;
+    }
+    void release() noexcept
+    {
+        if (mRep && mRep->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            destroy_rep(mRep);
+        }
+        mRep = nullptr;
+    }
+
+    // replaces a shared buffer with a private copy; the copy reserves
+    // space for at least capacity elements
+    void unshare(size_type capacity)
+    {
+        auto copy = make_rep(mAlloc);
+        try
+        {
+            copy->items.reserve(std::max(capacity, size()));
+            copy->items.insert(copy->items.end(), mRep->items.cbegin(), mRep->items.cend());
+        }
+        catch (...)
+        {
+            destroy_rep(copy);
+            throw;
+        }
+        release();
+        mRep = copy;
+    }
+    storage & unshared()
+    {
+        if (!unique())
+        {
+            unshare(size());
+        }
+        return mRep->items;
+    }
+    storage & mutable_items(size_type capacity)
+    {
+        if (!mRep)
+        {
+            mRep = make_rep(mAlloc);
+        }
+        else if (!unique())
+        {
+            unshare(capacity);
+        }
+        return mRep->items;
+    }
+
+    Allocator mAlloc;
+    rep *mRep;
+};
+
+
+// copies share all lists; modifications copy the lists along their path
+using cow_node = basic_node<std::string, cow_vector>;
+
+namespace pmr
+{
+template< class T >
+using cow_vector = sexpr::cow_vector<T, std::pmr::polymorphic_allocator<T>>;
+
+// copies into another memory resource are deep copies
+using cow_node = basic_node<std::pmr::string, pmr::cow_vector>;
+}
+
+}
@@ -0,0 +1,248 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <limits>
+#include <string>
+#include <vector>
+#include <utility>
+#include <string_view>
+#include <type_traits>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/reader.hpp>
+#include <sexpr-cpp/parser.hpp>
+#include <sexpr-cpp/emitter.hpp>
+
+
+namespace sexpr
+{
+
+// pull parser for the canonical (length prefixed) encoding, e.g.
+//     (3:foo(3:bar))
+// atoms are views into the input and never contain escape sequences;
+// whitespace and display hints are not part of the canonical form.
+class csexp_reader
+{
+public:
+    csexp_reader() noexcept
+        : csexp_reader(nullptr, nullptr)
+    {
+    }
+    csexp_reader(const char *first, const char *last) noexcept
+        : mFirst(first)
+        , mPos(first)
+        , mLast(last)
+        , mDepth(0)
+    {
+    }
+    explicit csexp_reader(std::string_view input) noexcept
+        : csexp_reader(input.data(), input.data() + input.size())
+    {
+    }
+
+    event next()
+    {
+        if (mPos == mLast)
+        {
+            if (mDepth)
+            {
+                throw parse_error("unexpected end of input within a list", offset());
+            }
+            return { event_type::end_of_input, { mPos, 0 }, false };
+        }
+
+        const char *start = mPos;
+        switch (*mPos)
+        {
+        case '(':
+            ++mDepth;
+            ++mPos;
+            return { event_type::list_begin, { start, 1 }, false };
+
+        case ')':
+            if (!mDepth)
+            {
+                throw parse_error("unbalanced closing parenthesis", offset());
+            }
+            --mDepth;
+            ++mPos;
+            return { event_type::list_end, { start, 1 }, false };
+
+        default:
+            break;
+        }
+
+        if (*mPos < '0' || *mPos > '9')
+        {
+            throw parse_error("expected a length prefix", offset());
+        }
+        if (*mPos == '0' && mLast - mPos > 1 && mPos[1] != ':')
+        {
+            throw parse_error("length prefixes must not contain leading zeros", offset());
+        }
+
+        std::size_t length = 0;
+        for (; mPos != mLast && *mPos >= '0' && *mPos <= '9'; ++mPos)
+        {
+            const auto digit = static_cast<std::size_t>(*mPos - '0');
+            if (length > (std::numeric_limits<std::size_t>::max() - digit) / 10)
+            {
+                throw parse_error("length prefix overflow", offset());
+            }
+            length = length * 10 + digit;
+        }
+        if (mPos == mLast || *mPos != ':')
+        {
+            throw parse_error("expected a ':' after the length prefix", offset());
+        }
+        ++mPos;
+        if (static_cast<std::size_t>(mLast - mPos) < length)
+        {
+            throw parse_error("the atom length exceeds the input", offset());
+        }
+
+        std::string_view value(mPos, length);
+        mPos += length;
+        return { event_type::atom, value, false };
+    }
+
+    std::size_t depth() const noexcept
+    {
+        return mDepth;
+    }
+    std::size_t offset() const noexcept
+    {
+        return static_cast<std::size_t>(mPos - mFirst);
+    }
+
+private:
+    const char *mFirst;
+    const char *mPos;
+    const char *mLast;
+    std::size_t mDepth;
+};
+
+
+template< class THandler >
+inline void read_csexp_events(std::string_view input, THandler &&handler)
+{
+    csexp_reader r(input);
+    for (auto e = r.next(); e.type != event_type::end_of_input; e = r.next())
+    {
+        detail::dispatch(e, handler);
+    }
+}
+
+// parses exactly one expression in canonical encoding
+template< class TNode = node,
+    class TAtomFactory = default_atom_factory<typename TNode::string>,
+    std::enable_if_t<std::is_invocable<TAtomFactory &, std::string_view, bool>::value, int> = 0 >
+inline TNode parse_csexp(std::string_view input, TAtomFactory makeAtom = TAtomFactory(),
+    const typename TNode::allocator_type &alloc = typename TNode::allocator_type())
+{
+    csexp_reader r(input);
+    return detail::parse_single<TNode>(r, input, std::move(makeAtom), alloc);
+}
+
+template< class TNode = node >
+inline TNode parse_csexp(std::string_view input, const typename TNode::allocator_type &alloc)
+{
+    return parse_csexp<TNode>(input, default_atom_factory<typename TNode::string>(), alloc);
+}
+
+
+namespace detail
+{
+template< class TOutput >
+inline void emit_csexp_atom(std::string_view atom, TOutput &out)
+{
+    char prefix[std::numeric_limits<std::size_t>::digits10 + 2];
+    char *last = prefix + sizeof(prefix);
+    char *pos = last;
+    *--pos = ':';
+    auto length = atom.size();
+    do
+    {
+        *--pos = static_cast<char>('0' + length % 10);
+        length /= 10;
+    }
+    while (length);
+
+    out.write(pos, static_cast<std::size_t>(last - pos));
+    out.write(atom.data(), atom.size());
+}
+
+template< class TNode, class TOutput >
+inline void emit_csexp_node(const TNode &root, TOutput &out)
+{
+    using iterator = typename TNode::const_iterator;
+    std::vector<std::pair<iterator, iterator>> stack;
+
+    const TNode *current = &root;
+    for (;;)
+    {
+        if (current)
+        {
+            if (current->is_string())
+            {
+                const auto &s = current->get_string();
+                emit_csexp_atom(std::string_view(s.data(), s.size()), out);
+            }
+            else
+            {
+                out.put('(');
+                stack.emplace_back(current->cbegin(), current->cend());
+            }
+            current = nullptr;
+        }
+
+        if (stack.empty())
+        {
+            break;
+        }
+        auto &top = stack.back();
+        if (top.first == top.second)
+        {
+            out.put(')');
+            stack.pop_back();
+            continue;
+        }
+        current = &*top.first++;
+    }
+}
+}
+
+
+// appends the canonical encoding of n to out
+template< class TNode >
+inline void emit_csexp(const TNode &n, std::string &out)
+{
+    detail::string_output output(out);
+    detail::emit_csexp_node(n, output);
+}
+
+// hands the canonical encoding of n in chunks to sink(const char *, std::size_t)
+template< class TNode, class TSink,
+    std::enable_if_t<std::is_invocable<TSink &, const char *, std::size_t>::value, int> = 0 >
+inline void emit_csexp(const TNode &n, TSink &&sink)
+{
+    detail::buffered_output<std::remove_reference_t<TSink>> output(sink);
+    detail::emit_csexp_node(n, output);
+    output.flush();
+}
+
+template< class TNode >
+inline std::string to_csexp(const TNode &n)
+{
+    std::string out;
+    emit_csexp(n, out);
+    return out;
+}
+
+}
@@ -7,17 +7,23 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
+#include <atomic>
 #include <string>
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <memory_resource>
+#include <utility>
 #include <iterator>
 #include <typeinfo>
 #include <stdexcept>
+#include <string_view>
 #include <type_traits>
 
-#include <boost/variant.hpp>
-#include <boost/iterator/iterator_adaptor.hpp>
-#include <boost/iterator/reverse_iterator.hpp>
 
 
 namespace sexpr
@@ -35,8 +41,8 @@ struct std_string_traits
 template< template<class, class...> class T >
 struct std_list_traits
 {
-    template< typename TComparator, class... TListTArgs >
-    static int compare(const T<TListTArgs...> &lhs, const T<TListTArgs...> &rhs, TComparator comp)
+    template< typename TComparator, class TListT >
+    static int compare(const TListT &lhs, const TListT &rhs, TComparator comp)
     {
         auto lit = lhs.cbegin(),
             lend = lhs.cend(),
@@ -54,6 +60,501 @@ struct std_list_traits
     }
 };
 
+// every node caches its structural hash (see hash.hpp); the cache is
+// invalidated by any non-const access to the node
+template< template<class, class...> class T >
+struct hash_caching_list_traits
+    : std_list_traits<T>
+{
+    static constexpr bool cache_hash = true;
+};
+
+// lists lazily build an index from the head atoms of their children to
+// the child positions which speeds up find_key() on wide association
+// lists; like the hash cache it is dropped by any non-const access
+template< template<class, class...> class T >
+struct key_indexing_list_traits
+    : std_list_traits<T>
+{
+    static constexpr bool index_keys = true;
+};
+
+
+namespace detail
+{
+template< class TString, class TAllocator, class = void >
+struct uses_string_allocator
+    : std::false_type
+{
+};
+template< class TString, class TAllocator >
+struct uses_string_allocator<TString, TAllocator, std::void_t<typename TString::allocator_type>>
+    : std::is_constructible<typename TString::allocator_type, const TAllocator &>
+{
+};
+
+// whether containers with this allocator can always exchange their buffers
+template< class TAllocator >
+struct swaps_buffers
+    : std::bool_constant<std::allocator_traits<TAllocator>::propagate_on_container_swap::value
+        || std::allocator_traits<TAllocator>::is_always_equal::value>
+{
+};
+
+// constructs the string with the (rebound) allocator if it supports one
+template< class TString, class TAllocator, class... TArgs >
+inline TString make_string(const TAllocator &alloc, TArgs&&... args)
+{
+    if constexpr (uses_string_allocator<TString, TAllocator>::value)
+    {
+        return TString(std::forward<TArgs>(args)..., typename TString::allocator_type(alloc));
+    }
+    else
+    {
+        return TString(std::forward<TArgs>(args)...);
+    }
+}
+
+
+template< class TListTraits, class = void >
+struct caches_hash
+    : std::false_type
+{
+};
+template< class TListTraits >
+struct caches_hash<TListTraits, std::void_t<decltype(TListTraits::cache_hash)>>
+    : std::integral_constant<bool, TListTraits::cache_hash>
+{
+};
+
+struct hash_cache_access;
+
+template< bool enabled >
+class hash_cache
+{
+protected:
+    void invalidate_hash() noexcept
+    {
+    }
+    void swap_hash(hash_cache &) noexcept
+    {
+    }
+};
+
+// 0 denotes a missing hash
+template<>
+class hash_cache<true>
+{
+    friend struct hash_cache_access;
+
+protected:
+    hash_cache() noexcept
+        : mHash(0)
+    {
+    }
+    hash_cache(const hash_cache &other) noexcept
+        : mHash(other.mHash.load(std::memory_order_relaxed))
+    {
+    }
+    hash_cache(hash_cache &&other) noexcept
+        : mHash(other.mHash.exchange(0, std::memory_order_relaxed))
+    {
+    }
+    hash_cache & operator=(const hash_cache &other) noexcept
+    {
+        mHash.store(other.mHash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+    hash_cache & operator=(hash_cache &&other) noexcept
+    {
+        mHash.store(other.mHash.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    void invalidate_hash() noexcept
+    {
+        mHash.store(0, std::memory_order_relaxed);
+    }
+    void swap_hash(hash_cache &other) noexcept
+    {
+        const auto tmp = mHash.load(std::memory_order_relaxed);
+        mHash.store(other.mHash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.mHash.store(tmp, std::memory_order_relaxed);
+    }
+
+private:
+    mutable std::atomic<std::size_t> mHash;
+};
+
+
+template< class TListTraits, class = void >
+struct indexes_keys
+    : std::false_type
+{
+};
+template< class TListTraits >
+struct indexes_keys<TListTraits, std::void_t<decltype(TListTraits::index_keys)>>
+    : std::integral_constant<bool, TListTraits::index_keys>
+{
+};
+
+// lists with fewer children are scanned linearly
+constexpr std::size_t key_index_threshold = 8;
+
+// open addressing table from key hashes to child positions; the keys
+// themselves aren't stored, i.e. the table stays valid if the children
+// are moved to another buffer
+class key_table
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // key_of(pos, key) returns false if the child has no head atom
+    template< class TKeyOf >
+    key_table(std::size_t size, TKeyOf key_of)
+        : mSlots()
+        , mMask(0)
+    {
+        std::size_t capacity = 16;
+        while (capacity < size * 2)
+        {
+            capacity *= 2;
+        }
+        mSlots.assign(capacity, slot{ 0, npos });
+        mMask = capacity - 1;
+
+        std::string_view key;
+        for (std::size_t pos = 0; pos < size; ++pos)
+        {
+            if (!key_of(pos, key))
+            {
+                continue;
+            }
+            const auto h = std::hash<std::string_view>()(key);
+            // the first occurrence of a key wins
+            if (find(key, h, key_of) == npos)
+            {
+                auto i = h & mMask;
+                while (mSlots[i].pos != npos)
+                {
+                    i = (i + 1) & mMask;
+                }
+                mSlots[i] = slot{ h, pos };
+            }
+        }
+    }
+
+    template< class TKeyOf >
+    std::size_t find(std::string_view key, TKeyOf key_of) const
+    {
+        return find(key, std::hash<std::string_view>()(key), key_of);
+    }
+
+private:
+    struct slot
+    {
+        std::size_t hash;
+        std::size_t pos;
+    };
+
+    template< class TKeyOf >
+    std::size_t find(std::string_view key, std::size_t h, TKeyOf &key_of) const
+    {
+        std::string_view candidate;
+        for (auto i = h & mMask; mSlots[i].pos != npos; i = (i + 1) & mMask)
+        {
+            if (mSlots[i].hash == h && key_of(mSlots[i].pos, candidate) && candidate == key)
+            {
+                return mSlots[i].pos;
+            }
+        }
+        return npos;
+    }
+
+    std::vector<slot> mSlots;
+    std::size_t mMask;
+};
+
+template< bool enabled >
+class key_index
+{
+protected:
+    void invalidate_index() noexcept
+    {
+    }
+    void swap_index(key_index &) noexcept
+    {
+    }
+};
+
+// the table is built by const member functions, so concurrent readers
+// race to publish it; the loser discards its table
+template<>
+class key_index<true>
+{
+protected:
+    key_index() noexcept
+        : mIndex(nullptr)
+    {
+    }
+    key_index(const key_index &) noexcept
+        : mIndex(nullptr)
+    {
+    }
+    key_index(key_index &&other) noexcept
+        : mIndex(other.mIndex.exchange(nullptr, std::memory_order_acq_rel))
+    {
+    }
+    key_index & operator=(const key_index &) noexcept
+    {
+        invalidate_index();
+        return *this;
+    }
+    key_index & operator=(key_index &&other) noexcept
+    {
+        delete mIndex.exchange(other.mIndex.exchange(nullptr, std::memory_order_acq_rel),
+            std::memory_order_acq_rel);
+        return *this;
+    }
+    ~key_index()
+    {
+        delete mIndex.load(std::memory_order_acquire);
+    }
+
+    void invalidate_index() noexcept
+    {
+        if (mIndex.load(std::memory_order_relaxed))
+        {
+            delete mIndex.exchange(nullptr, std::memory_order_acq_rel);
+        }
+    }
+    void swap_index(key_index &other) noexcept
+    {
+        const auto tmp = mIndex.load(std::memory_order_acquire);
+        mIndex.store(other.mIndex.load(std::memory_order_acquire), std::memory_order_release);
+        other.mIndex.store(tmp, std::memory_order_release);
+    }
+
+    const key_table * index() const noexcept
+    {
+        return mIndex.load(std::memory_order_acquire);
+    }
+    const key_table * publish_index(std::unique_ptr<key_table> table) const noexcept
+    {
+        key_table *expected = nullptr;
+        if (mIndex.compare_exchange_strong(expected, table.get(),
+            std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            return table.release();
+        }
+        return expected;
+    }
+
+private:
+    mutable std::atomic<key_table *> mIndex;
+};
+}
+
+
+namespace detail
+{
+// the storage of basic_node: a list or a string
+//
+// unlike boost::variant there is no never-empty guarantee to maintain,
+// because move constructing both alternatives doesn't throw. Move
+// assigning may allocate, e.g. std::pmr containers with unequal memory
+// resources. Copy assignment constructs the new value before it destroys
+// the old one.
+template< class TList, class TString >
+class node_content
+{
+    static constexpr bool nothrow_move_constructible
+        = std::is_nothrow_move_constructible<TList>::value
+        && std::is_nothrow_move_constructible<TString>::value;
+    static constexpr bool nothrow_move_assignable = nothrow_move_constructible
+        && std::is_nothrow_move_assignable<TList>::value
+        && std::is_nothrow_move_assignable<TString>::value;
+
+public:
+    static constexpr unsigned char list_index = 0;
+    static constexpr unsigned char string_index = 1;
+
+    node_content() noexcept(std::is_nothrow_default_constructible<TList>::value)
+        : mWhich(list_index)
+    {
+        ::new (static_cast<void *>(&mList)) TList();
+    }
+    node_content(const TList &l)
+        : mWhich(list_index)
+    {
+        ::new (static_cast<void *>(&mList)) TList(l);
+    }
+    node_content(TList &&l) noexcept(std::is_nothrow_move_constructible<TList>::value)
+        : mWhich(list_index)
+    {
+        ::new (static_cast<void *>(&mList)) TList(std::move(l));
+    }
+    node_content(const TString &str)
+        : mWhich(string_index)
+    {
+        ::new (static_cast<void *>(&mString)) TString(str);
+    }
+    node_content(TString &&str) noexcept(std::is_nothrow_move_constructible<TString>::value)
+        : mWhich(string_index)
+    {
+        ::new (static_cast<void *>(&mString)) TString(std::move(str));
+    }
+
+    node_content(const node_content &other)
+        : mWhich(other.mWhich)
+    {
+        if (mWhich == list_index)
+        {
+            ::new (static_cast<void *>(&mList)) TList(other.mList);
+        }
+        else
+        {
+            ::new (static_cast<void *>(&mString)) TString(other.mString);
+        }
+    }
+    node_content(node_content &&other) noexcept(nothrow_move_constructible)
+        : mWhich(other.mWhich)
+    {
+        if (mWhich == list_index)
+        {
+            ::new (static_cast<void *>(&mList)) TList(std::move(other.mList));
+        }
+        else
+        {
+            ::new (static_cast<void *>(&mString)) TString(std::move(other.mString));
+        }
+    }
+
+    node_content & operator=(const node_content &other)
+    {
+        if (this != &other)
+        {
+            if (mWhich == other.mWhich)
+            {
+                if (mWhich == list_index)
+                {
+                    mList = other.mList;
+                }
+                else
+                {
+                    mString = other.mString;
+                }
+            }
+            else
+            {
+                node_content tmp(other);
+                *this = std::move(tmp);
+            }
+        }
+        return *this;
+    }
+    node_content & operator=(node_content &&other) noexcept(nothrow_move_assignable)
+    {
+        if (this != &other)
+        {
+            if (mWhich == other.mWhich)
+            {
+                if (mWhich == list_index)
+                {
+                    mList = std::move(other.mList);
+                }
+                else
+                {
+                    mString = std::move(other.mString);
+                }
+            }
+            else
+            {
+                destroy();
+                ::new (static_cast<void *>(this)) node_content(std::move(other));
+            }
+        }
+        return *this;
+    }
+
+    ~node_content()
+    {
+        destroy();
+    }
+
+    int which() const noexcept
+    {
+        return mWhich;
+    }
+    const std::type_info & type() const noexcept
+    {
+        return mWhich == list_index ? typeid(TList) : typeid(TString);
+    }
+
+    template< class T >
+    T * get_if() noexcept
+    {
+        if constexpr (std::is_same<T, TList>::value)
+        {
+            return mWhich == list_index ? &mList : nullptr;
+        }
+        else
+        {
+            static_assert(std::is_same<T, TString>::value, "T must be one of the alternatives");
+            return mWhich == string_index ? &mString : nullptr;
+        }
+    }
+    template< class T >
+    const T * get_if() const noexcept
+    {
+        return const_cast<node_content *>(this)->template get_if<T>();
+    }
+
+    // swapping equal alternatives never allocates
+    void swap(node_content &other) noexcept(nothrow_move_constructible)
+    {
+        if (mWhich == other.mWhich)
+        {
+            using std::swap;
+            if (mWhich == list_index)
+            {
+                swap(mList, other.mList);
+            }
+            else
+            {
+                swap(mString, other.mString);
+            }
+        }
+        else
+        {
+            node_content tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+    }
+
+private:
+    void destroy() noexcept
+    {
+        if (mWhich == list_index)
+        {
+            mList.~TList();
+        }
+        else
+        {
+            mString.~TString();
+        }
+    }
+
+    union
+    {
+        TList mList;
+        TString mString;
+    };
+    unsigned char mWhich;
+};
+}
+
 
 template< class TString,
     template<class, class...> class TList,
@@ -61,6 +562,61 @@ template< class TString,
     class TListTraits = std_list_traits<TList> >
 class basic_node;
 
+
+namespace detail
+{
+// the iterative algorithms (comparison, copy and destruction) are only
+// used if the list ordering is the lexicographical one of std_list_traits
+template< class TNode >
+struct has_std_list_order;
+template< class TString,
+    template<class, class...> class TList,
+    class TStringTraits,
+    class TListTraits >
+struct has_std_list_order<basic_node<TString, TList, TStringTraits, TListTraits>>
+    : std::is_base_of<std_list_traits<TList>, TListTraits>
+{
+};
+
+template< class TList, class = void >
+struct has_reserve
+    : std::false_type
+{
+};
+template< class TList >
+struct has_reserve<TList, std::void_t<decltype(std::declval<TList &>().reserve(std::size_t()))>>
+    : std::true_type
+{
+};
+
+// lists whose copies share their elements until either one is modified,
+// e.g. cow_vector
+template< class TList, class = void >
+struct shares_storage
+    : std::false_type
+{
+};
+template< class TList >
+struct shares_storage<TList, std::void_t<decltype(TList::shares_storage)>>
+    : std::integral_constant<bool, TList::shares_storage>
+{
+};
+
+// the elements of shared lists must not be moved elsewhere
+template< class TList >
+inline bool owns_elements(const TList &l) noexcept
+{
+    if constexpr (shares_storage<TList>::value)
+    {
+        return l.unique();
+    }
+    else
+    {
+        return true;
+    }
+}
+}
+
 enum class node_type
 {
     list = 0,
@@ -73,7 +629,12 @@ template< class TString,
     class TStringTraits,
     class TListTraits >
 class basic_node
+    : public detail::hash_cache<detail::caches_hash<TListTraits>::value>
+    , public detail::key_index<detail::indexes_keys<TListTraits>::value>
 {
+    using hash_base = detail::hash_cache<detail::caches_hash<TListTraits>::value>;
+    using index_base = detail::key_index<detail::indexes_keys<TListTraits>::value>;
+
 public:
     using string = TString;
     using string_traits = TStringTraits;
@@ -86,30 +647,136 @@ public:
     };
 
 private:
-    using content = boost::variant<list, string>;
+    using content = detail::node_content<list, string>;
 
     template< class T >
     class basic_iterator
-        : public boost::iterator_adaptor< basic_iterator<T>,
-             std::conditional_t< std::is_const<T>::value, typename list::const_iterator, typename list::iterator > >
     {
-        friend class boost::iterator_core_access;
+        template< class >
+        friend class basic_iterator;
 
         using base_iterator_t = std::conditional_t< std::is_const<T>::value, typename list::const_iterator, typename list::iterator >;
+        using base_traits = std::iterator_traits<base_iterator_t>;
+
     public:
+        using iterator_category = typename base_traits::iterator_category;
+        using value_type = std::remove_const_t<T>;
+        using difference_type = typename base_traits::difference_type;
+        using pointer = T *;
+        using reference = T &;
+
         basic_iterator() = default;
 
-        explicit basic_iterator(base_iterator_t v)
-            : basic_iterator::iterator_adaptor_(v)
+        explicit basic_iterator(base_iterator_t v)
+            : mBase(v)
+        {
+        }
+
+        template<class OtherValue,
+            std::enable_if_t<std::is_convertible<OtherValue*, T*>::value, int> = 0>
+        basic_iterator(const basic_iterator<OtherValue> &other)
+            : mBase(other.mBase)
+        {
+        }
+
+        const base_iterator_t & base() const noexcept
+        {
+            return mBase;
+        }
+
+        reference operator*() const
+        {
+            return *mBase;
+        }
+        pointer operator->() const
+        {
+            return &*mBase;
+        }
+        reference operator[](difference_type n) const
+        {
+            return mBase[n];
+        }
+
+        basic_iterator & operator++()
+        {
+            ++mBase;
+            return *this;
+        }
+        basic_iterator operator++(int)
+        {
+            return basic_iterator(mBase++);
+        }
+        basic_iterator & operator--()
+        {
+            --mBase;
+            return *this;
+        }
+        basic_iterator operator--(int)
+        {
+            return basic_iterator(mBase--);
+        }
+        basic_iterator & operator+=(difference_type n)
+        {
+            mBase += n;
+            return *this;
+        }
+        basic_iterator & operator-=(difference_type n)
+        {
+            mBase -= n;
+            return *this;
+        }
+
+        friend basic_iterator operator+(basic_iterator it, difference_type n)
+        {
+            return it += n;
+        }
+        friend basic_iterator operator+(difference_type n, basic_iterator it)
+        {
+            return it += n;
+        }
+        friend basic_iterator operator-(basic_iterator it, difference_type n)
         {
+            return it -= n;
+        }
+        template< class U >
+        difference_type operator-(const basic_iterator<U> &other) const
+        {
+            return mBase - other.mBase;
         }
 
-        template<class OtherValue,
-            std::enable_if_t<std::is_convertible<OtherValue*, T*>::value, int> = 0>
-        basic_iterator(const basic_iterator<OtherValue> &other)
-            : basic_iterator::iterator_adaptor_(other.base())
+        template< class U >
+        bool operator==(const basic_iterator<U> &other) const
+        {
+            return mBase == other.mBase;
+        }
+        template< class U >
+        bool operator!=(const basic_iterator<U> &other) const
+        {
+            return mBase != other.mBase;
+        }
+        template< class U >
+        bool operator<(const basic_iterator<U> &other) const
+        {
+            return mBase < other.mBase;
+        }
+        template< class U >
+        bool operator>(const basic_iterator<U> &other) const
+        {
+            return mBase > other.mBase;
+        }
+        template< class U >
+        bool operator<=(const basic_iterator<U> &other) const
+        {
+            return mBase <= other.mBase;
+        }
+        template< class U >
+        bool operator>=(const basic_iterator<U> &other) const
         {
+            return mBase >= other.mBase;
         }
+
+    private:
+        base_iterator_t mBase;
     };
 
 public:
@@ -123,20 +790,83 @@ public:
 
     using iterator = basic_iterator<basic_node>;
     using const_iterator = basic_iterator<const basic_node>;
-    using reverse_iterator = boost::reverse_iterator<iterator>;
-    using const_reverse_iterator = boost::reverse_iterator<const_iterator>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    // the allocator is propagated to the list and (if supported) the string
+    // which makes the node usable with uses-allocator construction,
+    // e.g. std::pmr containers
+    using allocator_type = typename list::allocator_type;
 
     basic_node() = default;
+    explicit basic_node(const allocator_type &alloc)
+        : mContent( list(alloc) )
+    {
+    }
+    basic_node(const basic_node &other, const allocator_type &alloc)
+        : hash_base(other)
+        , index_base(other)
+        , mContent( copy_content(other, alloc) )
+    {
+    }
+    basic_node(basic_node &&other, const allocator_type &alloc)
+        : mContent( other.is_list()
+            ? content( list(std::move(*other.try_get_list()), alloc) )
+            : content( detail::make_string<string>(alloc, std::move(*other.try_get_string())) ) )
+    {
+    }
+    // copies deep trees without recursion
+    basic_node(const basic_node &other)
+        : hash_base(other)
+        , index_base(other)
+        , mContent( copy_content(other, std::allocator_traits<allocator_type>
+            ::select_on_container_copy_construction(other.get_allocator())) )
+    {
+    }
+    basic_node(basic_node &&) = default;
+
     basic_node(string s)
-        : mContent(s)
+        : mContent(std::move(s))
+    {
+    }
+    basic_node(string s, const allocator_type &alloc)
+        : mContent( detail::make_string<string>(alloc, std::move(s)) )
     {
     }
     template< std::size_t n >
     basic_node(const char (&str)[n], bool remove_trailing_null = true)
-        : mContent( std::string{str, n - (remove_trailing_null && !str[n-1]) } )
+        : mContent( string{str, n - (remove_trailing_null && !str[n-1]) } )
+    {
+        static_assert(n, "you tried to initialize a node with a zero sized char array (which itself is illegal C++ anyway)");
+    }
+    template< std::size_t n >
+    basic_node(const char (&str)[n], const allocator_type &alloc)
+        : mContent( detail::make_string<string>(alloc, str, n - !str[n-1]) )
     {
         static_assert(n, "you tried to initialize a node with a zero sized char array (which itself is illegal C++ anyway)");
     }
+    // the atom is copied, e.g. directly into the memory resource of a
+    // std::pmr tree by uses-allocator construction
+    template< class TView,
+        std::enable_if_t<
+            std::is_same<TView, std::string_view>::value
+            && !std::is_same<string, std::string_view>::value, int
+        > = 0
+    >
+    basic_node(TView str)
+        : mContent( string(str.data(), str.size()) )
+    {
+    }
+    template< class TView,
+        std::enable_if_t<
+            std::is_same<TView, std::string_view>::value
+            && !std::is_same<string, std::string_view>::value, int
+        > = 0
+    >
+    basic_node(TView str, const allocator_type &alloc)
+        : mContent( detail::make_string<string>(alloc, str.data(), str.size()) )
+    {
+    }
     template< class TInputIterator,
         std::enable_if_t<
             std::is_base_of<
@@ -149,10 +879,62 @@ public:
         : mContent( list(first, last) )
     {
     }
+    template< class TInputIterator,
+        std::enable_if_t<
+            std::is_base_of<
+                std::forward_iterator_tag,
+                typename std::iterator_traits<TInputIterator>::iterator_category
+            >::value, int
+        > = 0
+    >
+    basic_node(TInputIterator first, TInputIterator last, const allocator_type &alloc)
+        : mContent( list(first, last, alloc) )
+    {
+    }
     basic_node(std::initializer_list<basic_node> il)
         : mContent( list(il) )
     {
     }
+    basic_node(std::initializer_list<basic_node> il, const allocator_type &alloc)
+        : mContent( list(il, alloc) )
+    {
+    }
+
+    basic_node & operator=(const basic_node &other)
+    {
+        // the copy uses our allocator which lets the move steal its lists
+        basic_node tmp(other, get_allocator());
+        return *this = std::move(tmp);
+    }
+    basic_node & operator=(basic_node &&) = default;
+
+    // tears down deep trees without recursion
+    ~basic_node()
+    {
+        if constexpr (detail::has_std_list_order<basic_node>::value)
+        {
+            if (auto pl = mContent.template get_if<list>())
+            {
+                flatten(*pl);
+            }
+        }
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        if (auto pl = try_get_as<list>())
+        {
+            return pl->get_allocator();
+        }
+        if constexpr (detail::uses_string_allocator<string, allocator_type>::value)
+        {
+            return allocator_type(try_get_as<string>()->get_allocator());
+        }
+        else
+        {
+            return allocator_type();
+        }
+    }
 
     explicit operator string() const
     {
@@ -402,6 +1184,48 @@ public:
         throw std::domain_error("basic_node::back() can only be used with lists");
     }
 
+    // association list lookup: returns the first child list whose head
+    // is an atom equal to key or nullptr
+    const basic_node * find_key(std::string_view key) const
+    {
+        auto pl = try_get_as<list>();
+        if (!pl)
+        {
+            throw std::domain_error("basic_node::find_key() can only be used with lists");
+        }
+
+        if constexpr (detail::indexes_keys<TListTraits>::value)
+        {
+            if (pl->size() >= detail::key_index_threshold)
+            {
+                // the list may have been changed through a reference which
+                // was obtained before the index was built, i.e. positions
+                // are revalidated and hits are checked against the key
+                auto key_of = [pl](std::size_t pos, std::string_view &out)
+                {
+                    return pos < pl->size() && head_atom((*pl)[pos], out);
+                };
+                auto table = this->index();
+                if (!table)
+                {
+                    table = this->publish_index(std::make_unique<detail::key_table>(pl->size(), key_of));
+                }
+                const auto pos = table->find(key, key_of);
+                return pos != detail::key_table::npos ? &(*pl)[pos] : nullptr;
+            }
+        }
+
+        std::string_view head;
+        for (const auto &child : *pl)
+        {
+            if (head_atom(child, head) && head == key)
+            {
+                return &child;
+            }
+        }
+        return nullptr;
+    }
+
 
     bool empty() const
     {
@@ -433,7 +1257,16 @@ public:
 
     void clear()
     {
-        boost::apply_visitor([](auto &e) { e.clear(); }, mContent);
+        this->invalidate_hash();
+        this->invalidate_index();
+        if (auto pl = mContent.template get_if<list>())
+        {
+            pl->clear();
+        }
+        else
+        {
+            mContent.template get_if<string>()->clear();
+        }
     }
 
     iterator insert(const_iterator pos, const basic_node &value)
@@ -525,7 +1358,7 @@ public:
     }
 
     template< typename... TArgs >
-    auto emplace_back(TArgs&&... args)
+    decltype(auto) emplace_back(TArgs&&... args)
     {
         if (auto pl = try_get_as<list>())
         {
@@ -569,29 +1402,352 @@ public:
         }
     }
 
-    void swap(basic_node &other)
-        noexcept(noexcept(std::declval<content>().swap(other.mContent)))
+    // nodes with unequal allocators which don't propagate (e.g. std::pmr
+    // trees of different memory resources) exchange copies instead
+    void swap(basic_node &other) noexcept(detail::swaps_buffers<allocator_type>::value
+        && noexcept(std::declval<content &>().swap(std::declval<content &>())))
     {
+        if constexpr (!detail::swaps_buffers<allocator_type>::value)
+        {
+            const auto alloc = get_allocator();
+            const auto otherAlloc = other.get_allocator();
+            if (alloc != otherAlloc)
+            {
+                basic_node theirs(other, alloc);
+                basic_node ours(*this, otherAlloc);
+                mContent = std::move(theirs.mContent);
+                other.mContent = std::move(ours.mContent);
+                this->swap_hash(other);
+                this->swap_index(other);
+                return;
+            }
+        }
         mContent.swap(other.mContent);
+        this->swap_hash(other);
+        this->swap_index(other);
     }
 
 
 private:
+    static bool head_atom(const basic_node &n, std::string_view &out) noexcept
+    {
+        auto pl = n.try_get_as<list>();
+        if (!pl || pl->empty())
+        {
+            return false;
+        }
+        auto ps = pl->front().template try_get_as<string>();
+        if (!ps)
+        {
+            return false;
+        }
+        out = std::string_view(ps->data(), ps->size());
+        return true;
+    }
+
+    static content copy_content(const basic_node &other, const allocator_type &alloc)
+    {
+        if (auto ps = other.try_get_string())
+        {
+            return content( detail::make_string<string>(alloc, *ps) );
+        }
+        if constexpr (detail::has_std_list_order<basic_node>::value)
+        {
+            if constexpr (detail::shares_storage<list>::value)
+            {
+                // O(1) unless the copy has to live in another resource
+                if (other.try_get_list()->get_allocator() == alloc)
+                {
+                    return content( list(*other.try_get_list(), alloc) );
+                }
+            }
+            content result{ list(alloc) };
+            deep_copy(*other.try_get_list(), *result.template get_if<list>());
+            return result;
+        }
+        else
+        {
+            return content( list(*other.try_get_list(), alloc) );
+        }
+    }
+
+    static void reserve(list &l, size_type n)
+    {
+        if constexpr (detail::has_reserve<list>::value)
+        {
+            l.reserve(n);
+        }
+    }
+
+    // depth first with an explicit stack; lists are reserved up front so
+    // the destination of every pending frame stays put
+    static void deep_copy(const list &src, list &dst)
+    {
+        struct frame
+        {
+            typename list::const_iterator it;
+            typename list::const_iterator end;
+            list *dst;
+        };
+        std::vector<frame> stack;
+
+        reserve(dst, src.size());
+        stack.push_back({ src.cbegin(), src.cend(), &dst });
+        while (!stack.empty())
+        {
+            auto &top = stack.back();
+            if (top.it == top.end)
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            const basic_node &child = *top.it++;
+            if (auto ps = child.try_get_string())
+            {
+                // a plain copy of the string would use the default allocator
+                top.dst->emplace_back(detail::make_string<string>(top.dst->get_allocator(), *ps));
+            }
+            else
+            {
+                const auto &children = *child.try_get_list();
+                auto &copy = *top.dst->emplace_back().mContent.template get_if<list>();
+                if (!children.empty())
+                {
+                    reserve(copy, children.size());
+                    stack.push_back({ children.cbegin(), children.cend(), &copy });
+                }
+            }
+        }
+    }
+
+    // grandchildren are moved into a single work list which is drained
+    // from the back, i.e. every node is destroyed without nested lists.
+    // The work list reuses the storage of the drained lists whenever
+    // possible. Should an allocation fail, the rest is destroyed normally.
+    // Shared lists merely drop a reference and are left alone.
+    static void flatten(list &l) noexcept
+    {
+        const auto nested = [](const basic_node &n)
+        {
+            auto pl = n.mContent.template get_if<list>();
+            return pl && !pl->empty() && detail::owns_elements(*pl);
+        };
+        if (!detail::owns_elements(l) || std::none_of(l.cbegin(), l.cend(), nested))
+        {
+            return;
+        }
+
+        try
+        {
+            list work(std::move(l));
+            while (!work.empty())
+            {
+                auto &back = work.back();
+                if (!nested(back))
+                {
+                    work.pop_back();
+                    continue;
+                }
+
+                list children(std::move(*back.mContent.template get_if<list>()));
+                work.pop_back();
+                if (work.size() < children.size() && work.get_allocator() == children.get_allocator())
+                {
+                    work.swap(children);
+                }
+                work.insert(work.end(), std::make_move_iterator(children.begin()),
+                    std::make_move_iterator(children.end()));
+            }
+        }
+        catch (...)
+        {
+        }
+    }
+
+    // every non-const access funnels through here
     template< class T >
     T * try_get_as() noexcept
     {
-        return boost::get<T>(&mContent);
+        this->invalidate_hash();
+        this->invalidate_index();
+        return mContent.template get_if<T>();
     }
     template< class T >
     const T * try_get_as() const noexcept
     {
-        return boost::get<const T>(&mContent);
+        return mContent.template get_if<T>();
     }
 
     content mContent;
 };
 
 
+namespace detail
+{
+template< class TString, class = void >
+struct has_char_data
+    : std::false_type
+{
+};
+template< class TString >
+struct has_char_data<TString, std::void_t<typename TString::traits_type>>
+    : std::is_same<typename TString::traits_type, std::char_traits<char>>
+{
+};
+
+// std_string_traits of char strings compare like memcmp
+template< class TNode >
+struct has_bytewise_atoms
+    : std::integral_constant<bool, has_char_data<typename TNode::string>::value
+        && std::is_same<typename TNode::string_traits, std_string_traits<typename TNode::string>>::value>
+{
+};
+
+template< class TNode >
+inline int compare_atoms(const typename TNode::string &lhs, const typename TNode::string &rhs)
+{
+    if constexpr (has_bytewise_atoms<TNode>::value)
+    {
+        const auto lsize = lhs.size();
+        const auto rsize = rhs.size();
+        if (int r = std::memcmp(lhs.data(), rhs.data(), lsize < rsize ? lsize : rsize))
+        {
+            return r;
+        }
+        return (lsize > rsize) - (lsize < rsize);
+    }
+    else
+    {
+        return TNode::string_traits::compare(lhs, rhs);
+    }
+}
+
+template< class TNode >
+inline bool equal_atoms(const typename TNode::string &lhs, const typename TNode::string &rhs)
+{
+    if constexpr (has_bytewise_atoms<TNode>::value)
+    {
+        return lhs.size() == rhs.size() && !std::memcmp(lhs.data(), rhs.data(), lhs.size());
+    }
+    else
+    {
+        return lhs == rhs;
+    }
+}
+
+// walks both trees in lockstep with an explicit stack; subtrees with
+// identical addresses are skipped
+template< bool equality, class TNode >
+inline int compare_iterative(const TNode &lhs, const TNode &rhs)
+{
+    using iterator = typename TNode::list::const_iterator;
+    struct frame
+    {
+        iterator lit;
+        iterator lend;
+        iterator rit;
+        iterator rend;
+    };
+    std::vector<frame> stack;
+
+    const TNode *l = &lhs;
+    const TNode *r = &rhs;
+    for (;;)
+    {
+        if (l != r)
+        {
+            const auto lt = l->which();
+            if (lt != r->which())
+            {
+                return (lt == node_type::list) - (lt == node_type::string);
+            }
+            if (lt == node_type::string)
+            {
+                if constexpr (equality)
+                {
+                    if (!equal_atoms<TNode>(*l->try_get_string(), *r->try_get_string()))
+                    {
+                        return 1;
+                    }
+                }
+                else if (int c = compare_atoms<TNode>(*l->try_get_string(), *r->try_get_string()))
+                {
+                    return c;
+                }
+            }
+            else
+            {
+                const auto &ll = *l->try_get_list();
+                const auto &rl = *r->try_get_list();
+                if (equality && ll.size() != rl.size())
+                {
+                    return 1;
+                }
+                stack.push_back({ ll.cbegin(), ll.cend(), rl.cbegin(), rl.cend() });
+            }
+        }
+
+        for (;;)
+        {
+            if (stack.empty())
+            {
+                return 0;
+            }
+            auto &top = stack.back();
+            const bool lmore = top.lit != top.lend;
+            const bool rmore = top.rit != top.rend;
+            if (lmore && rmore)
+            {
+                l = &*top.lit++;
+                r = &*top.rit++;
+                break;
+            }
+            if (lmore != rmore)
+            {
+                return lmore - rmore;
+            }
+            stack.pop_back();
+        }
+    }
+}
+
+template< class TString,
+    template<class, class...> class TList,
+    class TStringTraits,
+    class TListTraits >
+inline int compare(const basic_node<TString, TList, TStringTraits, TListTraits> &lhs,
+    const basic_node<TString, TList, TStringTraits, TListTraits> &rhs)
+{
+    using node_t = basic_node<TString, TList, TStringTraits, TListTraits>;
+    if constexpr (has_std_list_order<node_t>::value)
+    {
+        return compare_iterative<false>(lhs, rhs);
+    }
+    else
+    {
+        auto lt = lhs.which();
+        auto rt = rhs.which();
+        if (lt == rt)
+        {
+            if (lt == node_type::list)
+            {
+                return TListTraits::compare(lhs.get_list(), rhs.get_list(),
+                    [](const auto &le, const auto &re)
+                {
+                    return compare(le, re);
+                });
+            }
+
+            return TStringTraits::compare(lhs.get_string(), rhs.get_string());
+        }
+
+        return (lt == node_type::list) - (lt == node_type::string);
+    }
+}
+}
+
+
 template< class TString,
     template<class, class...> class TList,
     class TStringTraits,
@@ -599,14 +1755,22 @@ template< class TString,
 inline bool operator==(const basic_node<TString, TList, TStringTraits, TListTraits> &lhs,
         const basic_node<TString, TList, TStringTraits, TListTraits> &rhs)
 {
-    auto lt = lhs.which();
-    if (lt == rhs.which())
+    using node_t = basic_node<TString, TList, TStringTraits, TListTraits>;
+    if constexpr (detail::has_std_list_order<node_t>::value)
+    {
+        return detail::compare_iterative<true>(lhs, rhs) == 0;
+    }
+    else
     {
-        return lt == node_type::list
-            ? lhs.get_list() == rhs.get_list()
-            : lhs.get_string() == rhs.get_string();
+        auto lt = lhs.which();
+        if (lt == rhs.which())
+        {
+            return lt == node_type::list
+                ? lhs.get_list() == rhs.get_list()
+                : lhs.get_string() == rhs.get_string();
+        }
+        return false;
     }
-    return false;
 }
 
 template< class TString,
@@ -641,36 +1805,6 @@ template< class TString,
 }
 
 
-namespace detail
-{
-template< class TString,
-    template<class, class...> class TList,
-    class TStringTraits,
-    class TListTraits >
-inline int compare(const basic_node<TString, TList, TStringTraits, TListTraits> &lhs,
-    const basic_node<TString, TList, TStringTraits, TListTraits> &rhs)
-{
-    //using node_t = basic_node<TString, TList, TStringTraits, TListTraits>;
-
-    auto lt = lhs.which();
-    auto rt = rhs.which();
-    if (lt == rt)
-    {
-        if (lt == node_type::list)
-        {
-            return TListTraits::compare(lhs.get_list(), rhs.get_list(),
-                [](const auto &le, const auto &re)
-            {
-                return compare(le, re);
-            });
-        }
-
-        return TStringTraits::compare(lhs.get_string(), rhs.get_string());
-    }
-
-    return (lt == node_type::list) - (lt == node_type::string);
-}
-}
 
 template< class TString,
     template<class, class...> class TList,
@@ -726,5 +1860,17 @@ inline void swap(basic_node<TString, TList, TStringTraits, TListTraits> &lhs,
 }
 
 using node = basic_node<std::string, std::vector>;
+// find_key() lookups on wide lists are answered by a lazily built index
+using indexed_node = basic_node<std::string, std::vector,
+    std_string_traits<std::string>, key_indexing_list_traits<std::vector>>;
+// atoms are borrowed from a buffer which has to outlive the tree
+using view_node = basic_node<std::string_view, std::vector>;
+
+namespace pmr
+{
+// all lists and strings of a tree share the memory resource of the root,
+// e.g. a std::pmr::monotonic_buffer_resource
+using node = basic_node<std::pmr::string, std::pmr::vector>;
+}
 
 }
@@ -0,0 +1,506 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/hash.hpp>
+
+
+namespace sexpr
+{
+
+enum class edit_type
+{
+    insert,
+    erase,
+    replace,
+};
+
+// path holds the child indices from the root to the affected node, i.e.
+// the last index is the position within the parent list. An empty path
+// denotes the root which can only be replaced. Edits are applied in
+// order and every path refers to the tree as left by the previous edits.
+template< class TNode = node >
+struct edit
+{
+    edit_type type;
+    std::vector<std::size_t> path;
+    // insert and replace: the new node
+    TNode value;
+};
+
+template< class TNode = node >
+using edit_script = std::vector<edit<TNode>>;
+
+
+namespace detail
+{
+// middle sections of lists which need more edits are paired up by
+// position instead
+constexpr std::size_t diff_max_distance = 1024;
+
+// structural hashes of subtrees; node types which cache their hashes
+// answer from the cache, the others hash every list at most once
+template< class TNode >
+class subtree_hashes
+{
+public:
+    std::size_t operator()(const TNode &n)
+    {
+        if constexpr (caches_hash<typename TNode::list_traits>::value)
+        {
+            return hash_value(n);
+        }
+        else
+        {
+            if (n.is_string())
+            {
+                return atom_hash(n.get_string());
+            }
+            if (auto memo = mHashes.find(&n); memo != mHashes.end())
+            {
+                return memo->second;
+            }
+
+            struct frame
+            {
+                const TNode *node;
+                typename TNode::const_iterator it;
+                typename TNode::const_iterator end;
+                std::uint64_t state;
+            };
+            std::vector<frame> stack;
+            stack.push_back({ &n, n.cbegin(), n.cend(), list_hash_seed });
+
+            std::size_t result = 0;
+            while (!stack.empty())
+            {
+                auto &top = stack.back();
+                if (top.it != top.end)
+                {
+                    const auto &child = *top.it++;
+                    std::size_t h;
+                    if (child.is_string())
+                    {
+                        h = atom_hash(child.get_string());
+                    }
+                    else if (auto memo = mHashes.find(&child); memo != mHashes.end())
+                    {
+                        h = memo->second;
+                    }
+                    else
+                    {
+                        stack.push_back({ &child, child.cbegin(), child.cend(), list_hash_seed });
+                        continue;
+                    }
+                    top.state = combine_list_hash(top.state, h);
+                    continue;
+                }
+
+                result = finish_list_hash(top.state, top.node->size());
+                mHashes.emplace(top.node, result);
+                stack.pop_back();
+                if (!stack.empty())
+                {
+                    stack.back().state = combine_list_hash(stack.back().state, result);
+                }
+            }
+            return result;
+        }
+    }
+
+private:
+    std::unordered_map<const TNode *, std::size_t> mHashes;
+};
+
+// Myers' O((n+m)d) algorithm; returns the pairs of matching positions in
+// ascending order or false if more than maxDistance edits are required
+template< class TEqual >
+inline bool myers_matches(std::size_t n, std::size_t m, TEqual eq, std::size_t maxDistance,
+    std::vector<std::pair<std::size_t, std::size_t>> &matches)
+{
+    using index = std::ptrdiff_t;
+    const auto N = static_cast<index>(n);
+    const auto M = static_cast<index>(m);
+    const auto D = static_cast<index>(std::min(n + m, maxDistance));
+
+    // v[k + offset] is the furthest x on diagonal k; trace[d] holds the
+    // diagonals -d..d as they were before step d
+    const index offset = D + 1;
+    std::vector<index> v(2 * offset + 1, 0);
+    std::vector<std::vector<index>> trace;
+
+    index d = 0;
+    for (;; ++d)
+    {
+        if (d > D)
+        {
+            return false;
+        }
+        trace.emplace_back(v.begin() + (offset - d), v.begin() + (offset + d + 1));
+
+        bool done = false;
+        for (index k = -d; k <= d; k += 2)
+        {
+            index x = k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])
+                ? v[offset + k + 1]
+                : v[offset + k - 1] + 1;
+            index y = x - k;
+            while (x < N && y < M && eq(static_cast<std::size_t>(x), static_cast<std::size_t>(y)))
+            {
+                ++x;
+                ++y;
+            }
+            v[offset + k] = x;
+            if (x >= N && y >= M)
+            {
+                done = true;
+                break;
+            }
+        }
+        if (done)
+        {
+            break;
+        }
+    }
+
+    matches.clear();
+    index x = N;
+    index y = M;
+    for (; d > 0; --d)
+    {
+        const auto &prev = trace[d];
+        const auto at = [&](index k) { return prev[k + d]; };
+        const index k = x - y;
+        const index prevK = k == -d || (k != d && at(k - 1) < at(k + 1)) ? k + 1 : k - 1;
+        const index prevX = at(prevK);
+        const index prevY = prevX - prevK;
+        while (x > prevX && y > prevY)
+        {
+            --x;
+            --y;
+            matches.emplace_back(static_cast<std::size_t>(x), static_cast<std::size_t>(y));
+        }
+        x = prevX;
+        y = prevY;
+    }
+    while (x > 0 && y > 0)
+    {
+        --x;
+        --y;
+        matches.emplace_back(static_cast<std::size_t>(x), static_cast<std::size_t>(y));
+    }
+    std::reverse(matches.begin(), matches.end());
+    return true;
+}
+}
+
+
+// computes an edit script which turns a into b
+//
+// Subtrees with equal structural hashes are considered equal and are
+// skipped, i.e. with a hash caching node type (e.g. hashed_node) the
+// work is proportional to the size of the change; other node types hash
+// the compared lists once. Lists whose children have been changed are
+// compared recursively, so edits stay local. Deep trees are handled
+// without recursion.
+template< class TNode >
+inline edit_script<TNode> diff(const TNode &a, const TNode &b)
+{
+    edit_script<TNode> script;
+    detail::subtree_hashes<TNode> hashes;
+
+    const auto same = [&hashes](const TNode &x, const TNode &y)
+    {
+        if (&x == &y)
+        {
+            return true;
+        }
+        if (x.which() != y.which())
+        {
+            return false;
+        }
+        if (x.is_string())
+        {
+            return x.get_string() == y.get_string();
+        }
+        return x.size() == y.size() && hashes(x) == hashes(y);
+    };
+
+    // the paths of pending lists are stored as a chain of parent links
+    constexpr std::size_t root = static_cast<std::size_t>(-1);
+    struct link
+    {
+        std::size_t parent;
+        std::size_t pos;
+    };
+    std::vector<link> links;
+    const auto path_of = [&links](std::size_t entry, std::size_t pos)
+    {
+        std::vector<std::size_t> path{ pos };
+        for (; entry != root; entry = links[entry].parent)
+        {
+            path.push_back(links[entry].pos);
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    };
+
+    if (same(a, b))
+    {
+        return script;
+    }
+    if (!a.is_list() || !b.is_list())
+    {
+        script.push_back({ edit_type::replace, {}, b });
+        return script;
+    }
+
+    // lists are compared once all edits of their parent are known, i.e.
+    // their position is the one within b
+    struct pending
+    {
+        const TNode *a;
+        const TNode *b;
+        std::size_t link;
+    };
+    std::vector<pending> stack{ { &a, &b, root } };
+    std::vector<std::pair<std::size_t, std::size_t>> matches;
+    while (!stack.empty())
+    {
+        const auto current = stack.back();
+        stack.pop_back();
+        const auto &la = *current.a;
+        const auto &lb = *current.b;
+        const auto n = la.size();
+        const auto m = lb.size();
+
+        std::size_t prefix = 0;
+        while (prefix < n && prefix < m && same(la[prefix], lb[prefix]))
+        {
+            ++prefix;
+        }
+        std::size_t suffix = 0;
+        while (suffix < n - prefix && suffix < m - prefix
+            && same(la[n - 1 - suffix], lb[m - 1 - suffix]))
+        {
+            ++suffix;
+        }
+
+        const auto aEnd = n - suffix;
+        const auto bEnd = m - suffix;
+        // the trimming already compared the only candidates of short middles
+        if (std::min(aEnd - prefix, bEnd - prefix) == 0
+            || (aEnd - prefix == 1 && bEnd - prefix == 1))
+        {
+            matches.clear();
+        }
+        else if (!detail::myers_matches(aEnd - prefix, bEnd - prefix,
+            [&](std::size_t i, std::size_t j) { return same(la[prefix + i], lb[prefix + j]); },
+            detail::diff_max_distance, matches))
+        {
+            matches.clear();
+        }
+        for (auto &match : matches)
+        {
+            match.first += prefix;
+            match.second += prefix;
+        }
+        matches.emplace_back(aEnd, bEnd);
+
+        // a[i, match) is replaced by b[pos, match); changed lists are paired
+        std::size_t i = prefix;
+        std::size_t pos = prefix;
+        for (const auto &match : matches)
+        {
+            const auto paired = std::min(match.first - i, match.second - pos);
+            for (std::size_t p = 0; p < paired; ++p, ++i, ++pos)
+            {
+                if (la[i].is_list() && lb[pos].is_list())
+                {
+                    links.push_back({ current.link, pos });
+                    stack.push_back({ &la[i], &lb[pos], links.size() - 1 });
+                }
+                else
+                {
+                    script.push_back({ edit_type::replace, path_of(current.link, pos), lb[pos] });
+                }
+            }
+            for (; i < match.first; ++i)
+            {
+                script.push_back({ edit_type::erase, path_of(current.link, pos), TNode() });
+            }
+            for (; pos < match.second; ++pos)
+            {
+                script.push_back({ edit_type::insert, path_of(current.link, pos), lb[pos] });
+            }
+            // skip the match itself
+            ++i;
+            ++pos;
+        }
+    }
+    return script;
+}
+
+
+// applies the edits with the mutation members of the node type
+template< class TNode >
+inline void patch(TNode &n, const edit_script<TNode> &script)
+{
+    for (const auto &e : script)
+    {
+        if (e.path.empty())
+        {
+            if (e.type != edit_type::replace)
+            {
+                throw std::domain_error("only replace edits can target the root");
+            }
+            n = e.value;
+            continue;
+        }
+
+        TNode *parent = &n;
+        for (auto it = e.path.cbegin(), last = std::prev(e.path.cend()); it != last; ++it)
+        {
+            parent = &parent->at(*it);
+        }
+        const auto idx = e.path.back();
+        switch (e.type)
+        {
+        case edit_type::insert:
+            if (idx > parent->size())
+            {
+                throw std::out_of_range("edit script insert position out of range");
+            }
+            parent->insert(parent->cbegin() + idx, e.value);
+            break;
+
+        case edit_type::erase:
+            parent->at(idx);
+            parent->erase(parent->cbegin() + idx);
+            break;
+
+        case edit_type::replace:
+            parent->at(idx) = e.value;
+            break;
+        }
+    }
+}
+
+
+// ((insert (1 0) value) (erase (2)) (replace () value))
+template< class TNode >
+inline TNode script_to_node(const edit_script<TNode> &script)
+{
+    using string = typename TNode::string;
+    static_assert(!std::is_same<string, std::string_view>::value,
+        "the node type has to own its atoms");
+    static constexpr std::string_view names[] = { "insert", "erase", "replace" };
+
+    TNode result;
+    const auto alloc = result.get_allocator();
+    for (const auto &e : script)
+    {
+        auto &entry = result.emplace_back();
+        const auto name = names[static_cast<int>(e.type)];
+        entry.emplace_back(detail::make_string<string>(alloc, name.data(), name.size()));
+
+        auto &path = entry.emplace_back();
+        for (auto idx : e.path)
+        {
+            const auto text = std::to_string(idx);
+            path.emplace_back(detail::make_string<string>(alloc, text.data(), text.size()));
+        }
+        if (e.type != edit_type::erase)
+        {
+            entry.push_back(e.value);
+        }
+    }
+    return result;
+}
+
+template< class TNode >
+inline edit_script<TNode> script_from_node(const TNode &n)
+{
+    const auto malformed = []()
+    {
+        return std::domain_error("malformed edit script");
+    };
+    if (!n.is_list())
+    {
+        throw malformed();
+    }
+
+    edit_script<TNode> script;
+    script.reserve(n.size());
+    for (const auto &entry : n)
+    {
+        if (!entry.is_list() || entry.size() < 2 || !entry[0].is_string() || !entry[1].is_list())
+        {
+            throw malformed();
+        }
+
+        const auto &name = entry[0].get_string();
+        const std::string_view type(name.data(), name.size());
+        edit<TNode> e{ edit_type::erase, {}, TNode() };
+        if (type == "insert")
+        {
+            e.type = edit_type::insert;
+        }
+        else if (type == "replace")
+        {
+            e.type = edit_type::replace;
+        }
+        else if (type != "erase")
+        {
+            throw malformed();
+        }
+        if (entry.size() != (e.type == edit_type::erase ? 2u : 3u))
+        {
+            throw malformed();
+        }
+
+        e.path.reserve(entry[1].size());
+        for (const auto &idx : entry[1])
+        {
+            if (!idx.is_string())
+            {
+                throw malformed();
+            }
+            const auto &text = idx.get_string();
+            const auto last = text.data() + text.size();
+            std::size_t value;
+            const auto r = std::from_chars(text.data(), last, value);
+            if (r.ec != std::errc() || r.ptr != last)
+            {
+                throw malformed();
+            }
+            e.path.push_back(value);
+        }
+        if (e.type != edit_type::erase)
+        {
+            e.value = entry[2];
+        }
+        script.push_back(std::move(e));
+    }
+    return script;
+}
+
+}
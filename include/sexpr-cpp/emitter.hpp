@@ -0,0 +1,290 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <string_view>
+#include <type_traits>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/scanner.hpp>
+
+
+namespace sexpr
+{
+
+enum class emit_style
+{
+    // everything on a single line
+    compact = 0,
+    // lists containing lists are broken into one child per line
+    pretty = 1,
+};
+
+struct emit_options
+{
+    emit_style style = emit_style::compact;
+    unsigned indent = 2;
+};
+
+
+namespace detail
+{
+// atoms need to be quoted if they are empty or contain whitespace,
+// parentheses or quotes; checked block-wise with the simd classifier
+inline bool needs_quoting(std::string_view atom) noexcept
+{
+    if (atom.empty())
+    {
+        return true;
+    }
+
+    const auto classify = classifier();
+    block_masks m;
+    const char *pos = atom.data();
+    const char *last = pos + atom.size();
+    for (; last - pos >= static_cast<std::ptrdiff_t>(block_size); pos += block_size)
+    {
+        classify(pos, m);
+        if (m.space | m.open | m.close | m.quote)
+        {
+            return true;
+        }
+    }
+    if (pos != last)
+    {
+        char tail[block_size];
+        std::memset(tail, 'a', sizeof(tail));
+        std::memcpy(tail, pos, static_cast<std::size_t>(last - pos));
+        classify(tail, m);
+        return (m.space | m.open | m.close | m.quote) != 0;
+    }
+    return false;
+}
+
+
+class string_output
+{
+public:
+    explicit string_output(std::string &out) noexcept
+        : mOut(&out)
+    {
+    }
+
+    void put(char c)
+    {
+        mOut->push_back(c);
+    }
+    void write(const char *data, std::size_t size)
+    {
+        mOut->append(data, size);
+    }
+    void flush()
+    {
+    }
+
+private:
+    std::string *mOut;
+};
+
+// collects the output in a fixed size buffer and hands it to the sink in
+// large chunks
+template< class TSink >
+class buffered_output
+{
+public:
+    explicit buffered_output(TSink &sink) noexcept
+        : mSink(sink)
+        , mSize(0)
+    {
+    }
+
+    void put(char c)
+    {
+        if (mSize == sizeof(mBuffer))
+        {
+            flush();
+        }
+        mBuffer[mSize++] = c;
+    }
+    void write(const char *data, std::size_t size)
+    {
+        if (size > sizeof(mBuffer) - mSize)
+        {
+            flush();
+            if (size >= sizeof(mBuffer))
+            {
+                mSink(data, size);
+                return;
+            }
+        }
+        std::memcpy(mBuffer + mSize, data, size);
+        mSize += size;
+    }
+    void flush()
+    {
+        if (mSize)
+        {
+            mSink(static_cast<const char *>(mBuffer), mSize);
+            mSize = 0;
+        }
+    }
+
+private:
+    TSink &mSink;
+    std::size_t mSize;
+    char mBuffer[4096];
+};
+
+
+template< class TOutput >
+inline void emit_atom(std::string_view atom, TOutput &out)
+{
+    if (!needs_quoting(atom))
+    {
+        out.write(atom.data(), atom.size());
+        return;
+    }
+
+    out.put('"');
+    const char *run = atom.data();
+    const char *last = run + atom.size();
+    for (const char *it = run; it != last; ++it)
+    {
+        if (*it == '"' || *it == '\\')
+        {
+            out.write(run, static_cast<std::size_t>(it - run));
+            out.put('\\');
+            run = it;
+        }
+    }
+    out.write(run, static_cast<std::size_t>(last - run));
+    out.put('"');
+}
+
+template< class TOutput >
+inline void emit_newline(TOutput &out, std::size_t width)
+{
+    static constexpr char spaces[] = "                                ";
+    out.put('\n');
+    for (; width > sizeof(spaces) - 1; width -= sizeof(spaces) - 1)
+    {
+        out.write(spaces, sizeof(spaces) - 1);
+    }
+    out.write(spaces, width);
+}
+
+template< class TNode >
+inline bool has_nested_list(const TNode &n)
+{
+    for (const auto &child : n)
+    {
+        if (child.is_list() && !child.empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// iterative in order to cope with arbitrarily deep trees
+template< class TNode, class TOutput >
+inline void emit_node(const TNode &root, TOutput &out, const emit_options &opts)
+{
+    struct frame
+    {
+        typename TNode::const_iterator it;
+        typename TNode::const_iterator end;
+        bool first;
+        bool broken;
+    };
+    std::vector<frame> stack;
+
+    const TNode *current = &root;
+    for (;;)
+    {
+        if (current)
+        {
+            if (current->is_string())
+            {
+                const auto &s = current->get_string();
+                emit_atom(std::string_view(s.data(), s.size()), out);
+            }
+            else if (current->empty())
+            {
+                out.write("()", 2);
+            }
+            else
+            {
+                out.put('(');
+                stack.push_back({ current->cbegin(), current->cend(), true,
+                    opts.style == emit_style::pretty && has_nested_list(*current) });
+            }
+            current = nullptr;
+        }
+
+        if (stack.empty())
+        {
+            break;
+        }
+
+        auto &top = stack.back();
+        if (top.it == top.end)
+        {
+            out.put(')');
+            stack.pop_back();
+            continue;
+        }
+        if (!top.first)
+        {
+            if (top.broken)
+            {
+                emit_newline(out, stack.size() * opts.indent);
+            }
+            else
+            {
+                out.put(' ');
+            }
+        }
+        top.first = false;
+        current = &*top.it++;
+    }
+}
+}
+
+
+// appends the textual representation of n to out
+template< class TNode >
+inline void emit(const TNode &n, std::string &out, const emit_options &opts = {})
+{
+    detail::string_output output(out);
+    detail::emit_node(n, output, opts);
+}
+
+// hands the textual representation of n in chunks to sink(const char *, std::size_t)
+template< class TNode, class TSink,
+    std::enable_if_t<std::is_invocable<TSink &, const char *, std::size_t>::value, int> = 0 >
+inline void emit(const TNode &n, TSink &&sink, const emit_options &opts = {})
+{
+    detail::buffered_output<std::remove_reference_t<TSink>> output(sink);
+    detail::emit_node(n, output, opts);
+    output.flush();
+}
+
+template< class TNode >
+inline std::string to_string(const TNode &n, const emit_options &opts = {})
+{
+    std::string out;
+    emit(n, out, opts);
+    return out;
+}
+
+}
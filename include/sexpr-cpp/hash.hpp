@@ -0,0 +1,269 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <functional>
+#include <string_view>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#include <sexpr-cpp/data.hpp>
+
+
+namespace sexpr
+{
+
+namespace detail
+{
+// wyhash (final version 4) by Wang Yi, released into the public domain
+constexpr std::uint64_t wy_secret[4] = {
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+};
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 wy_uint128;
+#endif
+
+inline void wy_mum(std::uint64_t &a, std::uint64_t &b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    const auto r = static_cast<wy_uint128>(a) * b;
+    a = static_cast<std::uint64_t>(r);
+    b = static_cast<std::uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    a = _umul128(a, b, &b);
+#else
+    const std::uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<std::uint32_t>(a),
+        lb = static_cast<std::uint32_t>(b);
+    const std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const std::uint64_t t = rl + (rm0 << 32);
+    std::uint64_t c = t < rl;
+    const std::uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    a = lo;
+#endif
+}
+
+inline std::uint64_t wy_mix(std::uint64_t a, std::uint64_t b) noexcept
+{
+    wy_mum(a, b);
+    return a ^ b;
+}
+
+inline std::uint64_t wy_read8(const unsigned char *p) noexcept
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+inline std::uint64_t wy_read4(const unsigned char *p) noexcept
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint64_t hash_bytes(const void *key, std::size_t len, std::uint64_t seed) noexcept
+{
+    const auto *p = static_cast<const unsigned char *>(key);
+    const auto *s = wy_secret;
+    seed ^= wy_mix(seed ^ s[0], s[1]);
+
+    std::uint64_t a;
+    std::uint64_t b;
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (wy_read4(p) << 32) | wy_read4(p + ((len >> 3) << 2));
+            b = (wy_read4(p + len - 4) << 32) | wy_read4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = (std::uint64_t{ p[0] } << 16) | (std::uint64_t{ p[len >> 1] } << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        std::size_t i = len;
+        if (i > 48)
+        {
+            std::uint64_t see1 = seed;
+            std::uint64_t see2 = seed;
+            do
+            {
+                seed = wy_mix(wy_read8(p) ^ s[1], wy_read8(p + 8) ^ seed);
+                see1 = wy_mix(wy_read8(p + 16) ^ s[2], wy_read8(p + 24) ^ see1);
+                see2 = wy_mix(wy_read8(p + 32) ^ s[3], wy_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            }
+            while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = wy_mix(wy_read8(p) ^ s[1], wy_read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wy_read8(p + i - 16);
+        b = wy_read8(p + i - 8);
+    }
+
+    a ^= s[1];
+    b ^= seed;
+    wy_mum(a, b);
+    return wy_mix(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+
+// the seeds keep ("foo") and "foo" apart
+constexpr std::uint64_t atom_hash_seed = 0x2d358dccaa6c78a5ull;
+constexpr std::uint64_t list_hash_seed = 0x8bb84b93962eacc9ull;
+
+inline std::size_t finish_list_hash(std::uint64_t state, std::size_t size) noexcept
+{
+    const auto h = static_cast<std::size_t>(wy_mix(state ^ size, wy_secret[2]));
+    // 0 marks a missing cache entry
+    return h ? h : 1;
+}
+
+inline std::uint64_t combine_list_hash(std::uint64_t state, std::size_t child) noexcept
+{
+    return wy_mix(state ^ child, wy_secret[1]);
+}
+
+template< class TString >
+inline std::size_t atom_hash(const TString &s) noexcept
+{
+    const auto h = static_cast<std::size_t>(hash_bytes(s.data(), s.size(), atom_hash_seed));
+    return h ? h : 1;
+}
+
+
+struct hash_cache_access
+{
+    template< class TNode >
+    static std::size_t load(const TNode &n) noexcept
+    {
+        if constexpr (caches_hash<typename TNode::list_traits>::value)
+        {
+            return static_cast<const hash_cache<true> &>(n).mHash.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    template< class TNode >
+    static void store(const TNode &n, std::size_t h) noexcept
+    {
+        if constexpr (caches_hash<typename TNode::list_traits>::value)
+        {
+            static_cast<const hash_cache<true> &>(n).mHash.store(h, std::memory_order_relaxed);
+        }
+    }
+};
+}
+
+
+// structural hash of a tree; computed iteratively in O(n) or in O(1) if
+// the node type caches the hash of every subtree and nothing changed
+template< class TNode >
+inline std::size_t hash_value(const TNode &n)
+{
+    using access = detail::hash_cache_access;
+
+    struct frame
+    {
+        const TNode *node;
+        typename TNode::const_iterator it;
+        typename TNode::const_iterator end;
+        std::uint64_t state;
+    };
+    std::vector<frame> stack;
+
+    const TNode *current = &n;
+    std::size_t result = 0;
+    for (;;)
+    {
+        if (current)
+        {
+            if (auto cached = access::load(*current))
+            {
+                result = cached;
+            }
+            else if (current->is_string())
+            {
+                result = detail::atom_hash(current->get_string());
+                access::store(*current, result);
+            }
+            else
+            {
+                stack.push_back({ current, current->cbegin(), current->cend(), detail::list_hash_seed });
+                result = 0;
+            }
+            current = nullptr;
+        }
+
+        if (stack.empty())
+        {
+            return result;
+        }
+        auto &top = stack.back();
+        if (result)
+        {
+            top.state = detail::combine_list_hash(top.state, result);
+            result = 0;
+        }
+        if (top.it != top.end)
+        {
+            current = &*top.it++;
+            continue;
+        }
+        result = detail::finish_list_hash(top.state, top.node->size());
+        access::store(*top.node, result);
+        stack.pop_back();
+    }
+}
+
+// the tree hashes every subtree once and caches the result
+using hashed_node = basic_node<std::string, std::vector,
+    std_string_traits<std::string>, hash_caching_list_traits<std::vector>>;
+
+}
+
+
+namespace std
+{
+template< class TString,
+    template<class, class...> class TList,
+    class TStringTraits,
+    class TListTraits >
+struct hash<sexpr::basic_node<TString, TList, TStringTraits, TListTraits>>
+{
+    std::size_t operator()(const sexpr::basic_node<TString, TList, TStringTraits, TListTraits> &n) const
+    {
+        return sexpr::hash_value(n);
+    }
+};
+}
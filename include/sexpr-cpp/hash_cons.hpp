@@ -0,0 +1,492 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <initializer_list>
+#include <stdexcept>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/reader.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+
+namespace sexpr
+{
+
+template< class TString >
+class basic_consed_node;
+
+template< class TString >
+class basic_hash_cons_table;
+
+
+namespace detail
+{
+inline std::size_t hash_combine(std::size_t seed, std::size_t value) noexcept
+{
+    return seed ^ (value + std::size_t{ 0x9e3779b97f4a7c15 } + (seed << 6) + (seed >> 2));
+}
+
+template< class TString >
+struct consed_data
+{
+    node_type type;
+    std::size_t hash;
+    // the table which owns this value or nullptr
+    const void *table;
+    TString text;
+    std::vector<basic_consed_node<TString>> children;
+};
+}
+
+
+// immutable handle to a (possibly shared) subtree; provides the read
+// interface of basic_node. Values created by the same table are unique,
+// i.e. equality of such values is a pointer comparison.
+template< class TString >
+class basic_consed_node
+{
+    template< class >
+    friend class basic_hash_cons_table;
+
+    using data = detail::consed_data<TString>;
+
+public:
+    using string = TString;
+    using list = std::vector<basic_consed_node>;
+    using type = node_type;
+
+    using value_type = basic_consed_node;
+    using size_type = typename list::size_type;
+    using difference_type = typename list::difference_type;
+    using reference = const basic_consed_node &;
+    using const_reference = const basic_consed_node &;
+
+    using iterator = typename list::const_iterator;
+    using const_iterator = typename list::const_iterator;
+    using reverse_iterator = typename list::const_reverse_iterator;
+    using const_reverse_iterator = typename list::const_reverse_iterator;
+
+    // an empty list
+    basic_consed_node()
+        : mData(empty_list())
+    {
+    }
+
+    type which() const noexcept
+    {
+        return mData->type;
+    }
+    bool is_list() const noexcept
+    {
+        return mData->type == node_type::list;
+    }
+    bool is_string() const noexcept
+    {
+        return mData->type == node_type::string;
+    }
+
+    const string & get_string() const
+    {
+        if (!is_string())
+        {
+            throw std::domain_error("basic_consed_node::get_string() can only be used with strings");
+        }
+        return mData->text;
+    }
+    const string * try_get_string() const noexcept
+    {
+        return is_string() ? &mData->text : nullptr;
+    }
+    const list & get_list() const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("basic_consed_node::get_list() can only be used with lists");
+        }
+        return mData->children;
+    }
+    const list * try_get_list() const noexcept
+    {
+        return is_list() ? &mData->children : nullptr;
+    }
+
+    const_iterator begin() const
+    {
+        return get_list().cbegin();
+    }
+    const_iterator cbegin() const
+    {
+        return get_list().cbegin();
+    }
+    const_iterator end() const
+    {
+        return get_list().cend();
+    }
+    const_iterator cend() const
+    {
+        return get_list().cend();
+    }
+    const_reverse_iterator rbegin() const
+    {
+        return get_list().crbegin();
+    }
+    const_reverse_iterator crbegin() const
+    {
+        return get_list().crbegin();
+    }
+    const_reverse_iterator rend() const
+    {
+        return get_list().crend();
+    }
+    const_reverse_iterator crend() const
+    {
+        return get_list().crend();
+    }
+
+    const_reference at(size_type idx) const
+    {
+        return get_list().at(idx);
+    }
+    const_reference operator[](size_type idx) const
+    {
+        return get_list()[idx];
+    }
+    const_reference front() const
+    {
+        return get_list().front();
+    }
+    const_reference back() const
+    {
+        return get_list().back();
+    }
+
+    bool empty() const noexcept
+    {
+        return is_list() && mData->children.empty();
+    }
+    size_type size() const noexcept
+    {
+        return is_list() ? mData->children.size() : 1;
+    }
+
+    // structural hash, computed once on construction
+    std::size_t hash() const noexcept
+    {
+        return mData->hash;
+    }
+    // true if both handles refer to the same shared subtree
+    bool shares(const basic_consed_node &other) const noexcept
+    {
+        return mData == other.mData;
+    }
+
+    friend bool operator==(const basic_consed_node &lhs, const basic_consed_node &rhs)
+    {
+        return equal(lhs, rhs);
+    }
+    friend bool operator!=(const basic_consed_node &lhs, const basic_consed_node &rhs)
+    {
+        return !equal(lhs, rhs);
+    }
+
+private:
+    explicit basic_consed_node(std::shared_ptr<const data> d) noexcept
+        : mData(std::move(d))
+    {
+    }
+
+    static const std::shared_ptr<const data> & empty_list()
+    {
+        static const std::shared_ptr<const data> empty = std::make_shared<const data>(
+            data{ node_type::list, detail::hash_combine(0, 0), nullptr, string(), list() });
+        return empty;
+    }
+
+    static bool equal(const basic_consed_node &lhs, const basic_consed_node &rhs)
+    {
+        struct frame
+        {
+            const_iterator lit;
+            const_iterator lend;
+            const_iterator rit;
+        };
+        std::vector<frame> stack;
+
+        const data *l = lhs.mData.get();
+        const data *r = rhs.mData.get();
+        for (;;)
+        {
+            if (l != r)
+            {
+                // values of the same table are unique, otherwise the hash
+                // filters almost all mismatches
+                if ((l->table && l->table == r->table)
+                    || l->hash != r->hash || l->type != r->type)
+                {
+                    return false;
+                }
+                if (l->type == node_type::string)
+                {
+                    if (!(l->text == r->text))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    if (l->children.size() != r->children.size())
+                    {
+                        return false;
+                    }
+                    stack.push_back({ l->children.cbegin(), l->children.cend(), r->children.cbegin() });
+                }
+            }
+
+            for (;;)
+            {
+                if (stack.empty())
+                {
+                    return true;
+                }
+                auto &top = stack.back();
+                if (top.lit != top.lend)
+                {
+                    l = (top.lit++)->mData.get();
+                    r = (top.rit++)->mData.get();
+                    break;
+                }
+                stack.pop_back();
+            }
+        }
+    }
+
+    std::shared_ptr<const data> mData;
+};
+
+
+// creates and owns unique immutable subtrees; a value is only created
+// if no structurally identical value exists yet. Not thread safe.
+template< class TString >
+class basic_hash_cons_table
+{
+    using data = detail::consed_data<TString>;
+
+public:
+    using value_type = basic_consed_node<TString>;
+
+    basic_hash_cons_table() = default;
+    basic_hash_cons_table(const basic_hash_cons_table &) = delete;
+    basic_hash_cons_table & operator=(const basic_hash_cons_table &) = delete;
+    ~basic_hash_cons_table()
+    {
+        // parents are released before their children which keeps the
+        // destruction of deep trees from recursing
+        mIndex.clear();
+        while (!mValues.empty())
+        {
+            mValues.pop_back();
+        }
+    }
+
+    value_type make_atom(std::string_view text)
+    {
+        const auto hash = detail::hash_combine(1, std::hash<std::string_view>()(text));
+        auto range = mIndex.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            const auto &d = *mValues[it->second];
+            if (d.type == node_type::string
+                && std::string_view(d.text.data(), d.text.size()) == text)
+            {
+                return value_type(mValues[it->second]);
+            }
+        }
+        return insert(hash, data{ node_type::string, hash, this,
+            detail::make_string<TString>(std::allocator<char>(), text.data(), text.size()), {} });
+    }
+
+    // children created elsewhere (e.g. default constructed ones) are
+    // interned first; the deduplication relies on unique children
+    template< class TIterator >
+    value_type make_list(TIterator first, TIterator last)
+    {
+        if (!std::all_of(first, last, [this](const value_type &c) { return c.mData->table == this; }))
+        {
+            std::vector<value_type> owned;
+            for (auto it = first; it != last; ++it)
+            {
+                owned.push_back(it->mData->table == this ? *it : intern(*it));
+            }
+            return make_list(owned.cbegin(), owned.cend());
+        }
+
+        std::size_t hash = 0;
+        std::size_t count = 0;
+        for (auto it = first; it != last; ++it, ++count)
+        {
+            hash = detail::hash_combine(hash, it->hash());
+        }
+        hash = detail::hash_combine(hash, count);
+
+        auto range = mIndex.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            const auto &d = *mValues[it->second];
+            if (d.type == node_type::list && d.children.size() == count
+                && std::equal(first, last, d.children.cbegin(),
+                    [](const value_type &l, const value_type &r) { return l.shares(r); }))
+            {
+                return value_type(mValues[it->second]);
+            }
+        }
+        return insert(hash, data{ node_type::list, hash, this, TString(),
+            typename value_type::list(first, last) });
+    }
+    value_type make_list(std::initializer_list<value_type> il)
+    {
+        return make_list(il.begin(), il.end());
+    }
+
+    // hash conses an existing tree
+    template< class TNode >
+    value_type intern(const TNode &n);
+
+    // number of unique values
+    std::size_t size() const noexcept
+    {
+        return mValues.size();
+    }
+
+private:
+    value_type insert(std::size_t hash, data &&d)
+    {
+        mValues.push_back(std::make_shared<const data>(std::move(d)));
+        mIndex.emplace(hash, mValues.size() - 1);
+        return value_type(mValues.back());
+    }
+
+    // in creation order, i.e. children precede their parents
+    std::vector<std::shared_ptr<const data>> mValues;
+    std::unordered_multimap<std::size_t, std::size_t> mIndex;
+};
+
+
+// event handler which assembles hash consed trees
+template< class TString >
+class hash_cons_builder
+{
+public:
+    using value_type = basic_consed_node<TString>;
+
+    explicit hash_cons_builder(basic_hash_cons_table<TString> &table) noexcept
+        : mTable(&table)
+    {
+    }
+
+    void begin_list()
+    {
+        mFrames.push_back(mValues.size());
+    }
+    void end_list()
+    {
+        auto first = mValues.begin() + mFrames.back();
+        auto list = mTable->make_list(first, mValues.end());
+        mValues.erase(first, mValues.end());
+        mFrames.pop_back();
+        mValues.push_back(std::move(list));
+    }
+    void atom(std::string_view value, bool escaped)
+    {
+        if (escaped)
+        {
+            mValues.push_back(mTable->make_atom(unescape(value)));
+        }
+        else
+        {
+            mValues.push_back(mTable->make_atom(value));
+        }
+    }
+
+    // number of currently open lists
+    std::size_t depth() const noexcept
+    {
+        return mFrames.size();
+    }
+
+    // completed top level values
+    std::vector<value_type> & values() noexcept
+    {
+        return mValues;
+    }
+
+private:
+    basic_hash_cons_table<TString> *mTable;
+    std::vector<value_type> mValues;
+    std::vector<std::size_t> mFrames;
+};
+
+
+template< class TString >
+template< class TNode >
+inline auto basic_hash_cons_table<TString>::intern(const TNode &n) -> value_type
+{
+    hash_cons_builder<TString> builder(*this);
+    walk_events(n, builder);
+    return std::move(builder.values().front());
+}
+
+
+using consed_node = basic_consed_node<std::string>;
+using hash_cons_table = basic_hash_cons_table<std::string>;
+
+
+// parses exactly one expression into the table
+template< class TString >
+inline basic_consed_node<TString> parse_consed(std::string_view input,
+    basic_hash_cons_table<TString> &table)
+{
+    reader r(input);
+    hash_cons_builder<TString> builder(table);
+    detail::read_single(r, input, builder);
+    return std::move(builder.values().front());
+}
+
+template< class TNode = node, class TString >
+inline TNode to_node(const basic_consed_node<TString> &n,
+    const typename TNode::allocator_type &alloc = typename TNode::allocator_type())
+{
+    tree_builder<TNode> builder(default_atom_factory<typename TNode::string>(), alloc);
+    walk_events(n, builder);
+    return std::move(builder.values().front());
+}
+
+}
+
+
+namespace std
+{
+template< class TString >
+struct hash<sexpr::basic_consed_node<TString>>
+{
+    std::size_t operator()(const sexpr::basic_consed_node<TString> &n) const noexcept
+    {
+        return n.hash();
+    }
+};
+}
@@ -0,0 +1,439 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/reader.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+
+namespace sexpr
+{
+
+class lazy_document;
+
+// read only view of a value within a lazy_document; mirrors the read
+// interface of basic_node, but children are handed out by value
+//
+// the children of a list are located the first time they are accessed;
+// nested lists are merely skipped at that point.
+class lazy_node
+{
+public:
+    using type = node_type;
+    using value_type = lazy_node;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = lazy_node;
+    using const_reference = lazy_node;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = lazy_node;
+        using difference_type = std::ptrdiff_t;
+        using reference = lazy_node;
+
+        struct pointer;
+
+        const_iterator() noexcept
+            : mDocument(nullptr)
+            , mIndex(0)
+        {
+        }
+        const_iterator(const lazy_document *document, std::size_t index) noexcept
+            : mDocument(document)
+            , mIndex(index)
+        {
+        }
+
+        reference operator*() const noexcept;
+        pointer operator->() const noexcept;
+
+        const_iterator & operator++() noexcept
+        {
+            ++mIndex;
+            return *this;
+        }
+        const_iterator operator++(int) noexcept
+        {
+            auto tmp = *this;
+            ++mIndex;
+            return tmp;
+        }
+
+        friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        {
+            return lhs.mDocument == rhs.mDocument && lhs.mIndex == rhs.mIndex;
+        }
+        friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        const lazy_document *mDocument;
+        std::size_t mIndex;
+    };
+    using iterator = const_iterator;
+
+
+    lazy_node() noexcept
+        : mDocument(nullptr)
+        , mIndex(0)
+    {
+    }
+    lazy_node(const lazy_document *document, std::size_t index) noexcept
+        : mDocument(document)
+        , mIndex(index)
+    {
+    }
+
+    type which() const noexcept;
+    bool is_list() const noexcept
+    {
+        return which() == type::list;
+    }
+    bool is_string() const noexcept
+    {
+        return which() == type::string;
+    }
+
+    // escape sequences have already been replaced
+    std::string_view get_string() const;
+    // lists: the source text including the parentheses
+    std::string_view text() const noexcept;
+
+    const_iterator begin() const;
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+    const_iterator end() const;
+    const_iterator cend() const
+    {
+        return end();
+    }
+
+    lazy_node operator[](size_type idx) const;
+    lazy_node at(size_type idx) const;
+    lazy_node front() const;
+    lazy_node back() const;
+
+    // lists: number of children, strings: 1
+    bool empty() const;
+    size_type size() const;
+
+    // returns the first child list whose head is an atom equal to key or
+    // an invalid node
+    lazy_node find_key(std::string_view key) const;
+    bool valid() const noexcept
+    {
+        return mDocument != nullptr;
+    }
+
+    const lazy_document * document() const noexcept
+    {
+        return mDocument;
+    }
+    // position within the value table of the document; the root is 0
+    std::size_t index() const noexcept
+    {
+        return mIndex;
+    }
+
+private:
+    const lazy_document *mDocument;
+    std::size_t mIndex;
+};
+
+struct lazy_node::const_iterator::pointer
+{
+    lazy_node value;
+
+    const lazy_node * operator->() const noexcept
+    {
+        return &value;
+    }
+};
+
+inline lazy_node lazy_node::const_iterator::operator*() const noexcept
+{
+    return { mDocument, mIndex };
+}
+inline lazy_node::const_iterator::pointer lazy_node::const_iterator::operator->() const noexcept
+{
+    return { **this };
+}
+
+
+// indexes the top level structure of the input on construction and the
+// children of every other list on first access; the input has to outlive
+// the document. Accessing a document isn't thread safe.
+class lazy_document
+{
+    friend class lazy_node;
+
+public:
+    explicit lazy_document(std::string_view input)
+        : mInput(input)
+        , mValues()
+        , mUnescaped()
+    {
+        mValues.push_back({ input, 0, 0, true, false });
+        expand(0);
+    }
+
+    lazy_document(const lazy_document &) = delete;
+    lazy_document & operator=(const lazy_document &) = delete;
+
+    // the top level values as a list
+    lazy_node root() const noexcept
+    {
+        return { this, 0 };
+    }
+
+    std::string_view input() const noexcept
+    {
+        return mInput;
+    }
+
+    // number of values which have been located so far
+    std::size_t num_indexed() const noexcept
+    {
+        return mValues.size();
+    }
+
+private:
+    // lists: the text including the parentheses; atoms: the atom content
+    struct value
+    {
+        std::string_view text;
+        std::size_t first;
+        std::size_t count;
+        bool list;
+        bool expanded;
+    };
+
+    const value & expanded(std::size_t idx) const
+    {
+        if (!mValues[idx].expanded)
+        {
+            expand(idx);
+        }
+        return mValues[idx];
+    }
+
+    // peeks at the head of unexpanded lists instead of indexing them
+    bool head_equals(std::size_t idx, std::string_view key) const
+    {
+        const auto &v = mValues[idx];
+        if (!v.list)
+        {
+            return false;
+        }
+        if (v.expanded)
+        {
+            return v.count && !mValues[v.first].list && mValues[v.first].text == key;
+        }
+
+        reader r(v.text);
+        r.next();
+        const auto e = r.next();
+        if (e.type != event_type::atom)
+        {
+            return false;
+        }
+        return e.escaped ? unescape(e.value) == key : e.value == key;
+    }
+
+    // appends the children of the list to the value table
+    void expand(std::size_t idx) const
+    {
+        const auto text = mValues[idx].text;
+        const auto first = mValues.size();
+        reader r(text);
+        if (idx)
+        {
+            // the opening parenthesis
+            r.next();
+        }
+        for (;;)
+        {
+            auto e = r.next();
+            if (e.type == event_type::list_end || e.type == event_type::end_of_input)
+            {
+                break;
+            }
+            if (e.type == event_type::atom)
+            {
+                auto content = e.value;
+                if (e.escaped)
+                {
+                    mUnescaped.push_back(unescape(content));
+                    content = mUnescaped.back();
+                }
+                mValues.push_back({ content, 0, 0, false, true });
+            }
+            else
+            {
+                const char *open = e.value.data();
+                const auto close = r.skip();
+                mValues.push_back({ std::string_view(open,
+                    static_cast<std::size_t>(close.value.data() + 1 - open)), 0, 0, true, false });
+            }
+        }
+
+        auto &v = mValues[idx];
+        v.first = first;
+        v.count = mValues.size() - first;
+        v.expanded = true;
+    }
+
+    std::string_view mInput;
+    mutable std::vector<value> mValues;
+    mutable std::deque<std::string> mUnescaped;
+};
+
+
+inline lazy_node::type lazy_node::which() const noexcept
+{
+    return mDocument->mValues[mIndex].list ? type::list : type::string;
+}
+
+inline std::string_view lazy_node::get_string() const
+{
+    const auto &v = mDocument->mValues[mIndex];
+    if (v.list)
+    {
+        throw std::domain_error("lazy_node::get_string() can only be used with strings");
+    }
+    return v.text;
+}
+
+inline std::string_view lazy_node::text() const noexcept
+{
+    return mDocument->mValues[mIndex].text;
+}
+
+inline lazy_node::const_iterator lazy_node::begin() const
+{
+    if (!is_list())
+    {
+        throw std::domain_error("lazy_node::begin() can only be used with lists");
+    }
+    return { mDocument, mDocument->expanded(mIndex).first };
+}
+
+inline lazy_node::const_iterator lazy_node::end() const
+{
+    if (!is_list())
+    {
+        throw std::domain_error("lazy_node::end() can only be used with lists");
+    }
+    const auto &v = mDocument->expanded(mIndex);
+    return { mDocument, v.first + v.count };
+}
+
+inline lazy_node lazy_node::operator[](size_type idx) const
+{
+    if (!is_list())
+    {
+        throw std::domain_error("lazy_node::operator[] can only be used with lists");
+    }
+    return { mDocument, mDocument->expanded(mIndex).first + idx };
+}
+
+inline lazy_node lazy_node::at(size_type idx) const
+{
+    if (!is_list())
+    {
+        throw std::domain_error("lazy_node::at() can only be used with lists");
+    }
+    const auto &v = mDocument->expanded(mIndex);
+    if (idx >= v.count)
+    {
+        throw std::out_of_range("lazy_node::at() index out of range");
+    }
+    return { mDocument, v.first + idx };
+}
+
+inline lazy_node lazy_node::front() const
+{
+    if (!is_list())
+    {
+        throw std::domain_error("lazy_node::front() can only be used with lists");
+    }
+    return (*this)[0];
+}
+
+inline lazy_node lazy_node::back() const
+{
+    if (!is_list())
+    {
+        throw std::domain_error("lazy_node::back() can only be used with lists");
+    }
+    return (*this)[size() - 1];
+}
+
+inline bool lazy_node::empty() const
+{
+    return is_list() && !mDocument->expanded(mIndex).count;
+}
+
+inline lazy_node::size_type lazy_node::size() const
+{
+    return is_list() ? mDocument->expanded(mIndex).count : 1;
+}
+
+inline lazy_node lazy_node::find_key(std::string_view key) const
+{
+    if (!is_list())
+    {
+        throw std::domain_error("lazy_node::find_key() can only be used with lists");
+    }
+    for (auto it = begin(), last = end(); it != last; ++it)
+    {
+        if (mDocument->head_equals(it->index(), key))
+        {
+            return *it;
+        }
+    }
+    return {};
+}
+
+
+// parses the value into a basic_node tree
+template< class TNode = node >
+inline TNode to_node(const lazy_node &n,
+    const typename TNode::allocator_type &alloc = typename TNode::allocator_type())
+{
+    if (n.is_string())
+    {
+        const auto s = n.get_string();
+        return TNode(detail::make_string<typename TNode::string>(alloc, s.data(), s.size()), alloc);
+    }
+    if (n.index())
+    {
+        return parse<TNode>(n.text(), alloc);
+    }
+    // the root isn't enclosed in parentheses
+    auto values = parse_all<TNode>(n.text(), alloc);
+    return TNode(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()), alloc);
+}
+
+}
@@ -0,0 +1,224 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <string_view>
+#include <system_error>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+
+namespace sexpr
+{
+
+// read only memory mapping of a whole file
+class mapped_file
+{
+public:
+    mapped_file() noexcept
+        : mData(nullptr)
+        , mSize(0)
+    {
+    }
+    explicit mapped_file(const std::string &path)
+        : mapped_file()
+    {
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw_last_error("sexpr::mapped_file: failed to open the file");
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            const auto error = last_error();
+            CloseHandle(file);
+            throw_error(error, "sexpr::mapped_file: failed to query the file size");
+        }
+        if (size.QuadPart)
+        {
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            const auto mappingError = last_error();
+            CloseHandle(file);
+            if (!mapping)
+            {
+                throw_error(mappingError, "sexpr::mapped_file: failed to create the file mapping");
+            }
+            void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            const auto mapError = last_error();
+            CloseHandle(mapping);
+            if (!data)
+            {
+                throw_error(mapError, "sexpr::mapped_file: failed to map the file");
+            }
+            mData = static_cast<const char *>(data);
+            mSize = static_cast<std::size_t>(size.QuadPart);
+        }
+        else
+        {
+            CloseHandle(file);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw_last_error("sexpr::mapped_file: failed to open the file");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            const auto error = last_error();
+            ::close(fd);
+            throw_error(error, "sexpr::mapped_file: failed to query the file size");
+        }
+        if (info.st_size > 0)
+        {
+            const auto size = static_cast<std::size_t>(info.st_size);
+            void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            const auto mapError = last_error();
+            ::close(fd);
+            if (data == MAP_FAILED)
+            {
+                throw_error(mapError, "sexpr::mapped_file: failed to map the file");
+            }
+            ::madvise(data, size, MADV_SEQUENTIAL);
+            mData = static_cast<const char *>(data);
+            mSize = size;
+        }
+        else
+        {
+            ::close(fd);
+        }
+#endif
+    }
+    mapped_file(mapped_file &&other) noexcept
+        : mData(std::exchange(other.mData, nullptr))
+        , mSize(std::exchange(other.mSize, 0))
+    {
+    }
+    mapped_file & operator=(mapped_file &&other) noexcept
+    {
+        mapped_file tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+    ~mapped_file()
+    {
+        if (mData)
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(mData);
+#else
+            ::munmap(const_cast<char *>(mData), mSize);
+#endif
+        }
+    }
+
+    const char * data() const noexcept
+    {
+        return mData;
+    }
+    std::size_t size() const noexcept
+    {
+        return mSize;
+    }
+    std::string_view view() const noexcept
+    {
+        return { mData, mSize };
+    }
+
+    void swap(mapped_file &other) noexcept
+    {
+        std::swap(mData, other.mData);
+        std::swap(mSize, other.mSize);
+    }
+
+private:
+    // has to be queried before the cleanup calls overwrite it
+    static int last_error() noexcept
+    {
+#if defined(_WIN32)
+        return static_cast<int>(GetLastError());
+#else
+        return errno;
+#endif
+    }
+    [[noreturn]] static void throw_error(int error, const char *what)
+    {
+#if defined(_WIN32)
+        throw std::system_error(error, std::system_category(), what);
+#else
+        throw std::system_error(error, std::generic_category(), what);
+#endif
+    }
+    [[noreturn]] static void throw_last_error(const char *what)
+    {
+        throw_error(last_error(), what);
+    }
+
+    const char *mData;
+    std::size_t mSize;
+};
+
+
+// an expression parsed from a mapped file; the atoms of the tree are
+// borrowed from the mapping (or the unescaped atom storage) which live
+// exactly as long as the document
+class mapped_document
+{
+public:
+    explicit mapped_document(const std::string &path)
+        : mFile(path)
+        , mUnescaped()
+        , mRoot(parse<view_node>(mFile.view(), borrowing_atom_factory(mUnescaped)))
+    {
+    }
+
+    mapped_document(mapped_document &&) = default;
+    mapped_document & operator=(mapped_document &&) = default;
+
+    view_node & root() noexcept
+    {
+        return mRoot;
+    }
+    const view_node & root() const noexcept
+    {
+        return mRoot;
+    }
+
+    const mapped_file & file() const noexcept
+    {
+        return mFile;
+    }
+
+private:
+    mapped_file mFile;
+    std::deque<std::string> mUnescaped;
+    view_node mRoot;
+};
+
+}
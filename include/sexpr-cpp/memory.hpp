@@ -0,0 +1,257 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <memory_resource>
+
+#include <sexpr-cpp/data.hpp>
+
+
+namespace sexpr
+{
+
+// memory footprint of a tree; heap figures are estimates based on the
+// container capacities and ignore allocator overhead
+struct node_memory_stats
+{
+    std::size_t nodes = 0;
+    std::size_t lists = 0;
+    std::size_t atoms = 0;
+    std::size_t max_depth = 0;
+
+    // sum of the atom lengths
+    std::size_t atom_bytes = 0;
+    // atom bytes which live in separately allocated buffers
+    std::size_t atom_heap_bytes = 0;
+
+    // allocated but unused list elements
+    std::size_t list_slack = 0;
+    std::size_t list_slack_bytes = 0;
+    std::size_t list_heap_bytes = 0;
+
+    // lists with allocated storage plus atoms which exceed the small
+    // string buffer
+    std::size_t heap_blocks = 0;
+
+    std::size_t heap_bytes() const noexcept
+    {
+        return list_heap_bytes + atom_heap_bytes;
+    }
+};
+
+
+namespace detail
+{
+template< class T, class = void >
+struct has_capacity
+    : std::false_type
+{
+};
+template< class T >
+struct has_capacity<T, std::void_t<decltype(std::declval<const T &>().capacity())>>
+    : std::true_type
+{
+};
+
+// strings which don't own a buffer have neither capacity() nor an allocator
+template< class TString >
+inline std::size_t string_heap_bytes(const TString &s) noexcept
+{
+    if constexpr (has_capacity<TString>::value)
+    {
+        // the capacity of an empty string is the small string buffer
+        static const auto inplace = TString().capacity();
+        return s.capacity() > inplace ? (s.capacity() + 1) * sizeof(typename TString::value_type) : 0;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+template< class TList >
+inline std::size_t list_capacity(const TList &l) noexcept
+{
+    if constexpr (has_capacity<TList>::value)
+    {
+        return l.capacity();
+    }
+    else
+    {
+        return l.size();
+    }
+}
+}
+
+
+// walks the tree iteratively
+template< class TNode >
+inline node_memory_stats memory_stats(const TNode &root)
+{
+    node_memory_stats stats;
+
+    struct frame
+    {
+        typename TNode::const_iterator it;
+        typename TNode::const_iterator end;
+    };
+    std::vector<frame> stack;
+
+    const TNode *current = &root;
+    for (;;)
+    {
+        if (current)
+        {
+            ++stats.nodes;
+            stats.max_depth = std::max(stats.max_depth, stack.size());
+            if (current->is_string())
+            {
+                const auto &s = current->get_string();
+                const auto heap = detail::string_heap_bytes(s);
+                ++stats.atoms;
+                stats.atom_bytes += s.size();
+                stats.atom_heap_bytes += heap;
+                stats.heap_blocks += heap != 0;
+            }
+            else
+            {
+                const auto &l = current->get_list();
+                const auto capacity = detail::list_capacity(l);
+                ++stats.lists;
+                stats.list_slack += capacity - l.size();
+                stats.list_heap_bytes += capacity * sizeof(TNode);
+                stats.heap_blocks += capacity != 0;
+                stack.push_back({ current->cbegin(), current->cend() });
+            }
+            current = nullptr;
+        }
+
+        if (stack.empty())
+        {
+            break;
+        }
+        auto &top = stack.back();
+        if (top.it == top.end)
+        {
+            stack.pop_back();
+            continue;
+        }
+        current = &*top.it++;
+    }
+    stats.list_slack_bytes = stats.list_slack * sizeof(TNode);
+    return stats;
+}
+
+
+struct allocation_stats
+{
+    // counted since the last reset()
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+    std::size_t bytes_allocated = 0;
+    std::size_t bytes_deallocated = 0;
+    // highest number of simultaneously allocated bytes since the last reset()
+    std::size_t peak_bytes = 0;
+    // currently allocated bytes
+    std::size_t live_bytes = 0;
+};
+
+// memory resource which counts the requests it forwards to its upstream;
+// use it with the pmr node types to instrument parsing and building, e.g.
+//     counting_resource res;
+//     auto n = parse<pmr::node>(text, &res);
+class counting_resource
+    : public std::pmr::memory_resource
+{
+public:
+    explicit counting_resource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) noexcept
+        : mUpstream(upstream)
+        , mAllocations(0)
+        , mDeallocations(0)
+        , mBytesAllocated(0)
+        , mBytesDeallocated(0)
+        , mPeakBytes(0)
+        , mLiveBytes(0)
+    {
+    }
+
+    allocation_stats stats() const noexcept
+    {
+        allocation_stats s;
+        s.allocations = mAllocations.load(std::memory_order_relaxed);
+        s.deallocations = mDeallocations.load(std::memory_order_relaxed);
+        s.bytes_allocated = mBytesAllocated.load(std::memory_order_relaxed);
+        s.bytes_deallocated = mBytesDeallocated.load(std::memory_order_relaxed);
+        s.peak_bytes = mPeakBytes.load(std::memory_order_relaxed);
+        s.live_bytes = mLiveBytes.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void reset() noexcept
+    {
+        mAllocations.store(0, std::memory_order_relaxed);
+        mDeallocations.store(0, std::memory_order_relaxed);
+        mBytesAllocated.store(0, std::memory_order_relaxed);
+        mBytesDeallocated.store(0, std::memory_order_relaxed);
+        mPeakBytes.store(mLiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    std::pmr::memory_resource * upstream_resource() const noexcept
+    {
+        return mUpstream;
+    }
+
+private:
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        auto p = mUpstream->allocate(bytes, alignment);
+        mAllocations.fetch_add(1, std::memory_order_relaxed);
+        mBytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+        const auto live = mLiveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        auto peak = mPeakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !mPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+        return p;
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        mUpstream->deallocate(p, bytes, alignment);
+        mDeallocations.fetch_add(1, std::memory_order_relaxed);
+        mBytesDeallocated.fetch_add(bytes, std::memory_order_relaxed);
+        mLiveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource *mUpstream;
+    std::atomic<std::size_t> mAllocations;
+    std::atomic<std::size_t> mDeallocations;
+    std::atomic<std::size_t> mBytesAllocated;
+    std::atomic<std::size_t> mBytesDeallocated;
+    std::atomic<std::size_t> mPeakBytes;
+    std::atomic<std::size_t> mLiveBytes;
+};
+
+// the allocations which fn() requested from the resource
+template< class TFunc >
+inline allocation_stats count_allocations(counting_resource &res, TFunc &&fn)
+{
+    res.reset();
+    std::forward<TFunc>(fn)();
+    return res.stats();
+}
+
+}
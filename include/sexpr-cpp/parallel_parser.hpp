@@ -0,0 +1,201 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <exception>
+#include <string_view>
+#include <type_traits>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/reader.hpp>
+#include <sexpr-cpp/parser.hpp>
+#include <sexpr-cpp/scanner.hpp>
+
+
+namespace sexpr
+{
+
+namespace detail
+{
+// chunks below this size aren't worth a thread
+constexpr std::size_t min_parallel_chunk = 64 * 1024;
+
+// returns the offsets which divide the input into roughly count chunks of
+// complete top level expressions; the first one is 0 and the last one
+// is input.size()
+//
+// only parentheses and quotes are visited. Malformed input simply ends the
+// splitting, the parser reports the error afterwards.
+inline std::vector<std::size_t> split_top_level(std::string_view input, std::size_t count)
+{
+    const char *first = input.data();
+    const char *last = first + input.size();
+    const std::size_t target = input.size() / count;
+
+    std::vector<std::size_t> bounds{ 0 };
+    block_scanner scan(first, last);
+    std::size_t depth = 0;
+    std::size_t next = target;
+    for (const char *pos = first; next < input.size(); )
+    {
+        pos = scan.find_list_token(pos);
+        if (pos == last)
+        {
+            break;
+        }
+
+        switch (*pos)
+        {
+        case '(':
+            ++depth;
+            ++pos;
+            break;
+
+        case ')':
+            if (!depth)
+            {
+                next = input.size();
+                break;
+            }
+            ++pos;
+            if (!--depth && static_cast<std::size_t>(pos - first) >= next)
+            {
+                bounds.push_back(static_cast<std::size_t>(pos - first));
+                next = bounds.back() + target;
+            }
+            break;
+
+        default:
+        {
+            bool escaped = false;
+            pos = scan.find_quote_end(pos + 1, escaped);
+            if (pos != last)
+            {
+                ++pos;
+            }
+            break;
+        }
+        }
+    }
+    if (bounds.back() != input.size())
+    {
+        bounds.push_back(input.size());
+    }
+    return bounds;
+}
+}
+
+
+// parses a sequence of top level expressions on multiple threads; the
+// result equals parse_all(input)
+//
+// The input is divided after closing parentheses at depth zero and the
+// chunks are parsed independently. threads == 0 selects
+// std::thread::hardware_concurrency(). The atom factory is copied for
+// every chunk and the allocator is shared by all threads, i.e. both must
+// be safe to use concurrently.
+template< class TNode = node,
+    class TAtomFactory = default_atom_factory<typename TNode::string>,
+    std::enable_if_t<std::is_invocable<TAtomFactory &, std::string_view, bool>::value, int> = 0 >
+inline std::vector<TNode> parse_all_parallel(std::string_view input, unsigned threads = 0,
+    TAtomFactory makeAtom = TAtomFactory(),
+    const typename TNode::allocator_type &alloc = typename TNode::allocator_type())
+{
+    if (!threads)
+    {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    // a few chunks per thread compensate for uneven expression sizes
+    const auto count = std::min<std::size_t>(std::size_t{ threads } * 4,
+        input.size() / detail::min_parallel_chunk);
+    if (threads == 1 || count <= 1)
+    {
+        return parse_all<TNode>(input, std::move(makeAtom), alloc);
+    }
+
+    const auto bounds = detail::split_top_level(input, count);
+    const auto chunks = bounds.size() - 1;
+    std::vector<std::vector<TNode>> results(chunks);
+    std::vector<std::exception_ptr> errors(chunks);
+
+    std::atomic<std::size_t> nextChunk(0);
+    auto work = [&]()
+    {
+        for (std::size_t i; (i = nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunks; )
+        {
+            const auto offset = bounds[i];
+            try
+            {
+                results[i] = parse_all<TNode>(input.substr(offset, bounds[i + 1] - offset),
+                    makeAtom, alloc);
+            }
+            catch (const parse_error &e)
+            {
+                errors[i] = std::make_exception_ptr(parse_error(e.what(), offset + e.offset()));
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const auto numWorkers = std::min<std::size_t>(threads, chunks) - 1;
+    workers.reserve(numWorkers);
+    try
+    {
+        for (std::size_t i = 0; i < numWorkers; ++i)
+        {
+            workers.emplace_back(work);
+        }
+    }
+    catch (...)
+    {
+        // the remaining chunks are processed by the threads we've got
+    }
+    work();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < chunks; ++i)
+    {
+        if (errors[i])
+        {
+            std::rethrow_exception(errors[i]);
+        }
+        total += results[i].size();
+    }
+
+    std::vector<TNode> values;
+    values.reserve(total);
+    for (auto &chunk : results)
+    {
+        values.insert(values.end(), std::make_move_iterator(chunk.begin()),
+            std::make_move_iterator(chunk.end()));
+    }
+    return values;
+}
+
+template< class TNode = node >
+inline std::vector<TNode> parse_all_parallel(std::string_view input, unsigned threads,
+    const typename TNode::allocator_type &alloc)
+{
+    return parse_all_parallel<TNode>(input, threads, default_atom_factory<typename TNode::string>(), alloc);
+}
+
+}
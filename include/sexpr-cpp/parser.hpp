@@ -0,0 +1,276 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/reader.hpp>
+
+
+namespace sexpr
+{
+
+template< class TString >
+struct default_atom_factory
+{
+    TString operator()(std::string_view value, bool escaped) const
+    {
+        return (*this)(value, escaped, std::allocator<char>());
+    }
+    // the allocator is used if the string type supports it
+    template< class TAllocator >
+    TString operator()(std::string_view value, bool escaped, const TAllocator &alloc) const
+    {
+        if (escaped)
+        {
+            auto unescaped = unescape(value);
+            if constexpr (std::is_same<TString, std::string>::value)
+            {
+                return unescaped;
+            }
+            else
+            {
+                return detail::make_string<TString>(alloc, unescaped.data(), unescaped.size());
+            }
+        }
+        return detail::make_string<TString>(alloc, value.data(), value.size());
+    }
+};
+
+
+// atoms without escape sequences are borrowed from the input
+template<>
+struct default_atom_factory<std::string_view>
+{
+    std::string_view operator()(std::string_view value, bool escaped) const
+    {
+        if (escaped)
+        {
+            throw std::domain_error("default_atom_factory<std::string_view> can only be used with atoms without escape sequences");
+        }
+        return value;
+    }
+};
+
+// borrows atoms from the input and stores unescaped atoms in a deque
+// which must outlive the tree (deque elements never move)
+class borrowing_atom_factory
+{
+public:
+    explicit borrowing_atom_factory(std::deque<std::string> &storage) noexcept
+        : mStorage(&storage)
+    {
+    }
+
+    std::string_view operator()(std::string_view value, bool escaped) const
+    {
+        if (escaped)
+        {
+            mStorage->push_back(unescape(value));
+            return mStorage->back();
+        }
+        return value;
+    }
+
+private:
+    std::deque<std::string> *mStorage;
+};
+
+
+// event handler which assembles basic_node trees
+//
+// children are collected on a value stack which is shared by all lists and
+// each list is created from its stack range in one go, i.e. every list
+// container is allocated exactly once with its final size.
+template< class TNode,
+    class TAtomFactory = default_atom_factory<typename TNode::string> >
+class tree_builder
+{
+public:
+    using value_type = TNode;
+    using allocator_type = typename TNode::allocator_type;
+
+    explicit tree_builder(TAtomFactory makeAtom = TAtomFactory(),
+            const allocator_type &alloc = allocator_type())
+        : mMakeAtom(std::move(makeAtom))
+        , mAlloc(alloc)
+        , mValues()
+        , mFrames()
+    {
+    }
+
+    void begin_list()
+    {
+        mFrames.push_back(mValues.size());
+    }
+    void end_list()
+    {
+        auto first = mValues.begin() + mFrames.back();
+        auto last = mValues.end();
+        TNode list(std::make_move_iterator(first), std::make_move_iterator(last), mAlloc);
+        mValues.erase(first, last);
+        mFrames.pop_back();
+        mValues.push_back(std::move(list));
+    }
+    void atom(std::string_view value, bool escaped)
+    {
+        if constexpr (std::is_invocable<TAtomFactory &, std::string_view, bool, const allocator_type &>::value)
+        {
+            mValues.emplace_back(mMakeAtom(value, escaped, mAlloc), mAlloc);
+        }
+        else
+        {
+            mValues.emplace_back(mMakeAtom(value, escaped), mAlloc);
+        }
+    }
+
+    // number of currently open lists
+    std::size_t depth() const noexcept
+    {
+        return mFrames.size();
+    }
+
+    // completed top level values
+    std::vector<TNode> & values() noexcept
+    {
+        return mValues;
+    }
+
+private:
+    TAtomFactory mMakeAtom;
+    allocator_type mAlloc;
+    std::vector<TNode> mValues;
+    std::vector<std::size_t> mFrames;
+};
+
+
+namespace detail
+{
+// feeds exactly one expression to the handler which has to report
+// the number of open lists via depth()
+template< class TReader, class THandler >
+inline void read_single(TReader &r, std::string_view input, THandler &handler)
+{
+    do
+    {
+        auto e = r.next();
+        if (e.type == event_type::end_of_input)
+        {
+            throw parse_error("the input doesn't contain an expression", r.offset());
+        }
+        dispatch(e, handler);
+    }
+    while (handler.depth());
+
+    auto trailing = r.next();
+    if (trailing.type != event_type::end_of_input)
+    {
+        throw parse_error("unexpected characters after the expression",
+            static_cast<std::size_t>(trailing.value.data() - input.data()));
+    }
+}
+
+template< class TNode, class TReader, class TAtomFactory >
+inline TNode parse_single(TReader &r, std::string_view input, TAtomFactory makeAtom,
+    const typename TNode::allocator_type &alloc)
+{
+    tree_builder<TNode, TAtomFactory> builder(std::move(makeAtom), alloc);
+    read_single(r, input, builder);
+    return std::move(builder.values().front());
+}
+}
+
+
+// generates the events which would be read from the textual
+// representation of n (atoms are never escaped)
+template< class TNode, class THandler >
+inline void walk_events(const TNode &n, THandler &&handler)
+{
+    using iterator = typename TNode::const_iterator;
+    std::vector<std::pair<iterator, iterator>> stack;
+
+    const TNode *current = &n;
+    for (;;)
+    {
+        if (current)
+        {
+            if (current->is_string())
+            {
+                const auto &s = current->get_string();
+                handler.atom(std::string_view(s.data(), s.size()), false);
+            }
+            else
+            {
+                handler.begin_list();
+                stack.emplace_back(current->cbegin(), current->cend());
+            }
+            current = nullptr;
+        }
+
+        if (stack.empty())
+        {
+            break;
+        }
+        auto &top = stack.back();
+        if (top.first == top.second)
+        {
+            handler.end_list();
+            stack.pop_back();
+            continue;
+        }
+        current = &*top.first++;
+    }
+}
+
+
+// parses exactly one expression (surrounded by optional whitespace)
+template< class TNode = node,
+    class TAtomFactory = default_atom_factory<typename TNode::string>,
+    std::enable_if_t<std::is_invocable<TAtomFactory &, std::string_view, bool>::value, int> = 0 >
+inline TNode parse(std::string_view input, TAtomFactory makeAtom = TAtomFactory(),
+    const typename TNode::allocator_type &alloc = typename TNode::allocator_type())
+{
+    reader r(input);
+    return detail::parse_single<TNode>(r, input, std::move(makeAtom), alloc);
+}
+
+template< class TNode = node >
+inline TNode parse(std::string_view input, const typename TNode::allocator_type &alloc)
+{
+    return parse<TNode>(input, default_atom_factory<typename TNode::string>(), alloc);
+}
+
+
+// parses a sequence of top level expressions
+template< class TNode = node,
+    class TAtomFactory = default_atom_factory<typename TNode::string>,
+    std::enable_if_t<std::is_invocable<TAtomFactory &, std::string_view, bool>::value, int> = 0 >
+inline std::vector<TNode> parse_all(std::string_view input, TAtomFactory makeAtom = TAtomFactory(),
+    const typename TNode::allocator_type &alloc = typename TNode::allocator_type())
+{
+    tree_builder<TNode, TAtomFactory> builder(std::move(makeAtom), alloc);
+    read_events(input, builder);
+    return std::move(builder.values());
+}
+
+template< class TNode = node >
+inline std::vector<TNode> parse_all(std::string_view input, const typename TNode::allocator_type &alloc)
+{
+    return parse_all<TNode>(input, default_atom_factory<typename TNode::string>(), alloc);
+}
+
+}
@@ -0,0 +1,696 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/reader.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+
+namespace sexpr
+{
+
+template< class TString >
+class basic_persistent_node;
+
+template< class TString >
+class persistent_builder;
+
+
+namespace detail
+{
+// the children of a list are stored in a 32-ary trie whose root is the
+// list itself, i.e. lists with up to 32 children consist of a single value
+constexpr unsigned persistent_bits = 5;
+constexpr std::size_t persistent_width = std::size_t{ 1 } << persistent_bits;
+constexpr std::size_t persistent_mask = persistent_width - 1;
+
+template< class TString >
+struct persistent_data
+{
+    enum class kind : unsigned char
+    {
+        atom,
+        list,
+        // inner trie node; never handed out
+        trie,
+    };
+
+    explicit persistent_data(kind k) noexcept
+        : which(k)
+        , shift(0)
+        , size(0)
+        , text()
+        , children()
+    {
+    }
+    persistent_data(const persistent_data &) = default;
+    ~persistent_data();
+
+    kind which;
+    // lists: number of index bits which are consumed above the last level
+    unsigned char shift;
+    // lists: number of elements
+    std::size_t size;
+    TString text;
+    // lists and trie nodes: up to 32 trie nodes or, on the last level,
+    // the elements
+    std::vector<basic_persistent_node<TString>> children;
+};
+}
+
+
+// immutable handle to a (possibly shared) subtree; provides the read
+// interface of basic_node. Updates return a new version which shares
+// every untouched subtree with the old one; replacing a child copies
+// O(log32(size)) trie nodes per list on the path. Handles can be copied
+// and released from multiple threads.
+template< class TString >
+class basic_persistent_node
+{
+    friend struct detail::persistent_data<TString>;
+    friend class persistent_builder<TString>;
+
+    using data = detail::persistent_data<TString>;
+    using kind = typename data::kind;
+
+public:
+    using string = TString;
+    using type = node_type;
+
+    using value_type = basic_persistent_node;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = const basic_persistent_node &;
+    using const_reference = const basic_persistent_node &;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = basic_persistent_node;
+        using difference_type = std::ptrdiff_t;
+        using reference = const basic_persistent_node &;
+        using pointer = const basic_persistent_node *;
+
+        const_iterator() noexcept
+            : mList(nullptr)
+            , mLeaf(nullptr)
+            , mIndex(0)
+        {
+        }
+
+        reference operator*() const noexcept
+        {
+            return mLeaf->children[mIndex & detail::persistent_mask];
+        }
+        pointer operator->() const noexcept
+        {
+            return &**this;
+        }
+
+        // the leaf is looked up once per 32 elements
+        const_iterator & operator++() noexcept
+        {
+            if ((++mIndex & detail::persistent_mask) == 0 && mIndex < mList->size)
+            {
+                mLeaf = leaf(*mList, mIndex);
+            }
+            return *this;
+        }
+        const_iterator operator++(int) noexcept
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        {
+            return lhs.mList == rhs.mList && lhs.mIndex == rhs.mIndex;
+        }
+        friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        friend class basic_persistent_node;
+
+        const_iterator(const data *list, size_type idx) noexcept
+            : mList(list)
+            , mLeaf(idx < list->size ? leaf(*list, idx) : nullptr)
+            , mIndex(idx)
+        {
+        }
+
+        const data *mList;
+        const data *mLeaf;
+        size_type mIndex;
+    };
+    using iterator = const_iterator;
+
+
+    // an empty list
+    basic_persistent_node()
+        : mData(empty_list())
+    {
+    }
+    basic_persistent_node(string s)
+        : mData(make_atom(std::move(s)))
+    {
+    }
+    template< std::size_t n >
+    basic_persistent_node(const char (&str)[n], bool remove_trailing_null = true)
+        : basic_persistent_node(string{ str, n - (remove_trailing_null && !str[n-1]) })
+    {
+        static_assert(n, "you tried to initialize a node with a zero sized char array (which itself is illegal C++ anyway)");
+    }
+    template< class TInputIterator,
+        std::enable_if_t<
+            std::is_base_of<
+                std::input_iterator_tag,
+                typename std::iterator_traits<TInputIterator>::iterator_category
+            >::value, int
+        > = 0
+    >
+    basic_persistent_node(TInputIterator first, TInputIterator last)
+        : basic_persistent_node(make_list(std::vector<basic_persistent_node>(first, last)))
+    {
+    }
+    basic_persistent_node(std::initializer_list<basic_persistent_node> il)
+        : basic_persistent_node(il.begin(), il.end())
+    {
+    }
+
+    type which() const noexcept
+    {
+        return mData->which == kind::atom ? type::string : type::list;
+    }
+    bool is_list() const noexcept
+    {
+        return which() == type::list;
+    }
+    bool is_string() const noexcept
+    {
+        return which() == type::string;
+    }
+
+    const string & get_string() const
+    {
+        if (!is_string())
+        {
+            throw std::domain_error("basic_persistent_node::get_string() can only be used with strings");
+        }
+        return mData->text;
+    }
+    const string * try_get_string() const noexcept
+    {
+        return is_string() ? &mData->text : nullptr;
+    }
+
+    const_iterator begin() const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("basic_persistent_node::begin() can only be used with lists");
+        }
+        return const_iterator(mData.get(), 0);
+    }
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+    const_iterator end() const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("basic_persistent_node::end() can only be used with lists");
+        }
+        return const_iterator(mData.get(), mData->size);
+    }
+    const_iterator cend() const
+    {
+        return end();
+    }
+
+    const_reference at(size_type idx) const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("basic_persistent_node::at() can only be used with lists");
+        }
+        if (idx >= mData->size)
+        {
+            throw std::out_of_range("basic_persistent_node::at() index out of range");
+        }
+        return element(*mData, idx);
+    }
+    const_reference operator[](size_type idx) const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("basic_persistent_node::operator[] can only be used with lists");
+        }
+        return element(*mData, idx);
+    }
+    const_reference front() const
+    {
+        return (*this)[0];
+    }
+    const_reference back() const
+    {
+        return (*this)[size() - 1];
+    }
+
+    bool empty() const noexcept
+    {
+        return is_list() && !mData->size;
+    }
+    size_type size() const noexcept
+    {
+        return is_list() ? mData->size : 1;
+    }
+
+    // association list lookup: returns the first child list whose head
+    // is an atom equal to key or nullptr
+    const basic_persistent_node * find_key(std::string_view key) const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("basic_persistent_node::find_key() can only be used with lists");
+        }
+        for (const auto &child : *this)
+        {
+            if (child.is_list() && !child.empty())
+            {
+                const auto ps = child.front().try_get_string();
+                if (ps && std::string_view(ps->data(), ps->size()) == key)
+                {
+                    return &child;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // returns a version whose child at idx is value; *this is unchanged
+    basic_persistent_node set(size_type idx, basic_persistent_node value) const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("basic_persistent_node::set() can only be used with lists");
+        }
+        if (idx >= mData->size)
+        {
+            throw std::out_of_range("basic_persistent_node::set() index out of range");
+        }
+
+        auto root = std::make_shared<data>(*mData);
+        data *current = root.get();
+        for (unsigned level = mData->shift; level > 0; level -= detail::persistent_bits)
+        {
+            current = &detach(current->children[(idx >> level) & detail::persistent_mask]);
+        }
+        current->children[idx & detail::persistent_mask] = std::move(value);
+        return basic_persistent_node(std::move(root));
+    }
+
+    // returns a version in which the node at the path of child indices
+    // is value, e.g. set_in({ 2, 0 }, v) replaces (*this)[2][0]
+    template< class TPath >
+    basic_persistent_node set_in(const TPath &path, basic_persistent_node value) const
+    {
+        const std::vector<size_type> indices(std::begin(path), std::end(path));
+        std::vector<const basic_persistent_node *> parents;
+        parents.reserve(indices.size());
+
+        const basic_persistent_node *current = this;
+        for (auto idx : indices)
+        {
+            parents.push_back(current);
+            current = &current->at(idx);
+        }
+        for (auto i = indices.size(); i-- > 0;)
+        {
+            value = parents[i]->set(indices[i], std::move(value));
+        }
+        return value;
+    }
+    basic_persistent_node set_in(std::initializer_list<size_type> path, basic_persistent_node value) const
+    {
+        return set_in<std::initializer_list<size_type>>(path, std::move(value));
+    }
+
+    // returns a version with value appended; *this is unchanged
+    basic_persistent_node push_back(basic_persistent_node value) const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("basic_persistent_node::push_back() can only be used with lists");
+        }
+
+        const auto idx = mData->size;
+        std::shared_ptr<data> root;
+        if (idx == detail::persistent_width << mData->shift)
+        {
+            // the trie is full; the old root becomes the first child
+            auto first = make(kind::trie);
+            first->children = mData->children;
+            root = make(kind::list);
+            root->shift = static_cast<unsigned char>(mData->shift + detail::persistent_bits);
+            root->children.reserve(2);
+            root->children.push_back(basic_persistent_node(std::move(first)));
+            root->children.push_back(make_path(mData->shift, std::move(value)));
+        }
+        else
+        {
+            root = std::make_shared<data>(*mData);
+            data *current = root.get();
+            unsigned level = mData->shift;
+            for (; level > 0; level -= detail::persistent_bits)
+            {
+                const auto slot = (idx >> level) & detail::persistent_mask;
+                if (slot == current->children.size())
+                {
+                    current->children.push_back(make_path(level - detail::persistent_bits, std::move(value)));
+                    break;
+                }
+                current = &detach(current->children[slot]);
+            }
+            if (level == 0)
+            {
+                current->children.push_back(std::move(value));
+            }
+        }
+        root->size = idx + 1;
+        return basic_persistent_node(std::move(root));
+    }
+
+    // true if both handles refer to the same shared subtree
+    bool shares(const basic_persistent_node &other) const noexcept
+    {
+        return mData == other.mData;
+    }
+
+    friend bool operator==(const basic_persistent_node &lhs, const basic_persistent_node &rhs)
+    {
+        return equal(lhs, rhs);
+    }
+    friend bool operator!=(const basic_persistent_node &lhs, const basic_persistent_node &rhs)
+    {
+        return !equal(lhs, rhs);
+    }
+
+private:
+    explicit basic_persistent_node(std::shared_ptr<const data> d) noexcept
+        : mData(std::move(d))
+    {
+    }
+
+    static std::shared_ptr<data> make(kind k)
+    {
+        return std::make_shared<data>(k);
+    }
+
+    static std::shared_ptr<data> make_atom(string s)
+    {
+        auto d = make(kind::atom);
+        d->text = std::move(s);
+        return d;
+    }
+
+    static const std::shared_ptr<const data> & empty_list()
+    {
+        static const std::shared_ptr<const data> empty = make(kind::list);
+        return empty;
+    }
+
+    static const data * leaf(const data &list, size_type idx) noexcept
+    {
+        const data *current = &list;
+        for (unsigned level = list.shift; level > 0; level -= detail::persistent_bits)
+        {
+            current = current->children[(idx >> level) & detail::persistent_mask].mData.get();
+        }
+        return current;
+    }
+    static const basic_persistent_node & element(const data &list, size_type idx) noexcept
+    {
+        return leaf(list, idx)->children[idx & detail::persistent_mask];
+    }
+
+    // replaces the trie node n refers to with a private copy
+    static data & detach(basic_persistent_node &n)
+    {
+        auto copy = std::make_shared<data>(*n.mData);
+        auto &result = *copy;
+        n.mData = std::move(copy);
+        return result;
+    }
+
+    // a chain of trie nodes down to the last level which holds value
+    static basic_persistent_node make_path(unsigned level, basic_persistent_node value)
+    {
+        for (;;)
+        {
+            auto parent = make(kind::trie);
+            parent->children.push_back(std::move(value));
+            value = basic_persistent_node(std::move(parent));
+            if (level == 0)
+            {
+                return value;
+            }
+            level -= detail::persistent_bits;
+        }
+    }
+
+    // builds the trie bottom up in O(n)
+    static basic_persistent_node make_list(std::vector<basic_persistent_node> &&elements)
+    {
+        if (elements.empty())
+        {
+            return basic_persistent_node();
+        }
+
+        auto root = make(kind::list);
+        root->size = elements.size();
+        auto level = std::move(elements);
+        while (level.size() > detail::persistent_width)
+        {
+            std::vector<basic_persistent_node> parents;
+            parents.reserve((level.size() + detail::persistent_mask) / detail::persistent_width);
+            for (std::size_t i = 0; i < level.size(); i += detail::persistent_width)
+            {
+                auto parent = make(kind::trie);
+                const auto last = std::min(level.size(), i + detail::persistent_width);
+                parent->children.assign(std::make_move_iterator(level.begin() + i),
+                    std::make_move_iterator(level.begin() + last));
+                parents.push_back(basic_persistent_node(std::move(parent)));
+            }
+            level = std::move(parents);
+            root->shift = static_cast<unsigned char>(root->shift + detail::persistent_bits);
+        }
+        root->children = std::move(level);
+        return basic_persistent_node(std::move(root));
+    }
+
+    static bool equal(const basic_persistent_node &lhs, const basic_persistent_node &rhs)
+    {
+        struct frame
+        {
+            const_iterator lit;
+            const_iterator lend;
+            const_iterator rit;
+        };
+        std::vector<frame> stack;
+
+        const basic_persistent_node *l = &lhs;
+        const basic_persistent_node *r = &rhs;
+        for (;;)
+        {
+            // shared subtrees are skipped
+            if (!l->shares(*r))
+            {
+                if (l->which() != r->which())
+                {
+                    return false;
+                }
+                if (l->is_string())
+                {
+                    if (!(l->mData->text == r->mData->text))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    if (l->mData->size != r->mData->size)
+                    {
+                        return false;
+                    }
+                    stack.push_back({ l->begin(), l->end(), r->begin() });
+                }
+            }
+
+            for (;;)
+            {
+                if (stack.empty())
+                {
+                    return true;
+                }
+                auto &top = stack.back();
+                if (top.lit != top.lend)
+                {
+                    l = &*top.lit++;
+                    r = &*top.rit++;
+                    break;
+                }
+                stack.pop_back();
+            }
+        }
+    }
+
+    std::shared_ptr<const data> mData;
+};
+
+
+// the grandchildren of values which are released for the last time are
+// moved into a single work list, i.e. deep trees are destroyed without
+// recursion. Should an allocation fail, the rest is destroyed normally.
+template< class TString >
+inline detail::persistent_data<TString>::~persistent_data()
+{
+    if (children.empty())
+    {
+        return;
+    }
+    try
+    {
+        auto work = std::move(children);
+        while (!work.empty())
+        {
+            auto child = std::move(work.back());
+            work.pop_back();
+            // no other handle exists, i.e. nobody else can observe the
+            // value; the fence pairs with the release of the other owners
+            if (child.mData.use_count() != 1 || child.mData->children.empty())
+            {
+                continue;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            auto &grandchildren = std::const_pointer_cast<persistent_data>(child.mData)->children;
+            if (work.size() < grandchildren.size())
+            {
+                work.swap(grandchildren);
+            }
+            work.insert(work.end(), std::make_move_iterator(grandchildren.begin()),
+                std::make_move_iterator(grandchildren.end()));
+            grandchildren.clear();
+        }
+    }
+    catch (...)
+    {
+    }
+}
+
+
+// event handler which assembles persistent trees
+template< class TString >
+class persistent_builder
+{
+public:
+    using value_type = basic_persistent_node<TString>;
+
+    void begin_list()
+    {
+        mFrames.push_back(mValues.size());
+    }
+    void end_list()
+    {
+        auto first = mValues.begin() + mFrames.back();
+        auto list = value_type::make_list(std::vector<value_type>(
+            std::make_move_iterator(first), std::make_move_iterator(mValues.end())));
+        mValues.erase(first, mValues.end());
+        mFrames.pop_back();
+        mValues.push_back(std::move(list));
+    }
+    void atom(std::string_view value, bool escaped)
+    {
+        if (escaped)
+        {
+            const auto text = unescape(value);
+            mValues.push_back(value_type(detail::make_string<TString>(std::allocator<char>(), text.data(), text.size())));
+        }
+        else
+        {
+            mValues.push_back(value_type(detail::make_string<TString>(std::allocator<char>(), value.data(), value.size())));
+        }
+    }
+
+    // number of currently open lists
+    std::size_t depth() const noexcept
+    {
+        return mFrames.size();
+    }
+
+    // completed top level values
+    std::vector<value_type> & values() noexcept
+    {
+        return mValues;
+    }
+
+private:
+    std::vector<value_type> mValues;
+    std::vector<std::size_t> mFrames;
+};
+
+
+using persistent_node = basic_persistent_node<std::string>;
+
+
+// parses exactly one expression
+template< class TString = std::string >
+inline basic_persistent_node<TString> parse_persistent(std::string_view input)
+{
+    reader r(input);
+    persistent_builder<TString> builder;
+    detail::read_single(r, input, builder);
+    return std::move(builder.values().front());
+}
+
+// copies a basic_node tree
+template< class TString = std::string, class TNode >
+inline basic_persistent_node<TString> make_persistent(const TNode &n)
+{
+    persistent_builder<TString> builder;
+    walk_events(n, builder);
+    return std::move(builder.values().front());
+}
+
+template< class TNode = node, class TString >
+inline TNode to_node(const basic_persistent_node<TString> &n,
+    const typename TNode::allocator_type &alloc = typename TNode::allocator_type())
+{
+    tree_builder<TNode> builder(default_atom_factory<typename TNode::string>(), alloc);
+    walk_events(n, builder);
+    return std::move(builder.values().front());
+}
+
+}
@@ -0,0 +1,312 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <string>
+#include <utility>
+#include <string_view>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/reader.hpp>
+#include <sexpr-cpp/parser.hpp>
+#include <sexpr-cpp/scanner.hpp>
+
+
+namespace sexpr
+{
+
+// resumable parser for input which arrives in arbitrary chunks
+//
+// every byte is classified exactly once; the only state carried over
+// between chunks is the list depth and an atom which is cut by a chunk
+// boundary. The handler receives the same events as with read_events(),
+// but atom views are only valid for the duration of the call.
+template< class THandler >
+class push_parser
+{
+public:
+    explicit push_parser(THandler handler = THandler())
+        : mHandler(std::move(handler))
+        , mPending()
+        , mOffset(0)
+        , mDepth(0)
+        , mState(state::idle)
+        , mEscaped(false)
+    {
+    }
+
+    void feed(const char *data, std::size_t size)
+    {
+        const char *pos = data;
+        const char *last = data + size;
+        block_scanner scan(data, last);
+
+        switch (mState)
+        {
+        case state::idle:
+            break;
+
+        case state::bare_atom:
+            pos = bare_atom(scan, pos, last);
+            break;
+
+        case state::quoted_escape:
+            if (pos == last)
+            {
+                break;
+            }
+            mPending.push_back(*pos++);
+            mState = state::quoted_atom;
+            pos = quoted_atom(scan, pos, pos, last);
+            break;
+
+        case state::quoted_atom:
+            pos = quoted_atom(scan, pos, pos, last);
+            break;
+        }
+
+        while (pos != last)
+        {
+            pos = scan.skip_space(pos);
+            if (pos == last)
+            {
+                break;
+            }
+
+            switch (*pos)
+            {
+            case '(':
+                ++mDepth;
+                ++pos;
+                mHandler.begin_list();
+                break;
+
+            case ')':
+                if (!mDepth)
+                {
+                    throw parse_error("unbalanced closing parenthesis", mOffset + static_cast<std::size_t>(pos - data));
+                }
+                --mDepth;
+                ++pos;
+                mHandler.end_list();
+                break;
+
+            case '"':
+                mEscaped = false;
+                pos = quoted_atom(scan, pos + 1, pos + 1, last);
+                break;
+
+            default:
+                pos = bare_atom(scan, pos, last);
+                break;
+            }
+        }
+        mOffset += size;
+    }
+    void feed(std::string_view chunk)
+    {
+        feed(chunk.data(), chunk.size());
+    }
+
+    // signals the end of the input which completes a pending bare atom
+    void finish()
+    {
+        switch (mState)
+        {
+        case state::idle:
+            break;
+
+        case state::bare_atom:
+            emit_pending();
+            break;
+
+        case state::quoted_atom:
+        case state::quoted_escape:
+            throw parse_error("unterminated quoted atom", mOffset);
+        }
+        if (mDepth)
+        {
+            throw parse_error("unexpected end of input within a list", mOffset);
+        }
+    }
+
+    // number of currently open lists
+    std::size_t depth() const noexcept
+    {
+        return mDepth;
+    }
+    // number of bytes fed so far
+    std::size_t offset() const noexcept
+    {
+        return mOffset;
+    }
+
+    THandler & handler() noexcept
+    {
+        return mHandler;
+    }
+    const THandler & handler() const noexcept
+    {
+        return mHandler;
+    }
+
+private:
+    enum class state : unsigned char
+    {
+        idle,
+        // mPending holds the beginning of an atom
+        bare_atom,
+        quoted_atom,
+        // the chunk ended right after a backslash
+        quoted_escape,
+    };
+
+    const char * bare_atom(block_scanner &scan, const char *pos, const char *last)
+    {
+        if (mState == state::idle)
+        {
+            // bare atoms are never unescaped
+            mEscaped = false;
+        }
+        const char *end = scan.find_atom_end(pos);
+        if (end == last)
+        {
+            mPending.append(pos, last);
+            mState = state::bare_atom;
+            return last;
+        }
+
+        if (mState == state::bare_atom)
+        {
+            mPending.append(pos, end);
+            emit_pending();
+        }
+        else
+        {
+            mHandler.atom(std::string_view(pos, static_cast<std::size_t>(end - pos)), false);
+        }
+        return end;
+    }
+
+    // start denotes the beginning of the unprocessed atom text in this chunk
+    const char * quoted_atom(block_scanner &scan, const char *start, const char *pos, const char *last)
+    {
+        for (;;)
+        {
+            pos = scan.find_quote_or_escape(pos);
+            if (pos == last)
+            {
+                mPending.append(start, last);
+                mState = state::quoted_atom;
+                return last;
+            }
+            if (*pos == '"')
+            {
+                break;
+            }
+
+            mEscaped = true;
+            if (last - pos == 1)
+            {
+                mPending.append(start, last);
+                mState = state::quoted_escape;
+                return last;
+            }
+            pos += 2;
+        }
+
+        if (mState != state::idle)
+        {
+            mPending.append(start, pos);
+            emit_pending();
+        }
+        else
+        {
+            mHandler.atom(std::string_view(start, static_cast<std::size_t>(pos - start)), mEscaped);
+        }
+        return pos + 1;
+    }
+
+    void emit_pending()
+    {
+        mState = state::idle;
+        mHandler.atom(std::string_view(mPending), mEscaped);
+        mPending.clear();
+    }
+
+    THandler mHandler;
+    std::string mPending;
+    std::size_t mOffset;
+    std::size_t mDepth;
+    state mState;
+    bool mEscaped;
+};
+
+
+// event handler which assembles the top level values and hands each one
+// to sink(TNode &&) as soon as it is complete
+template< class TNode, class TSink,
+    class TAtomFactory = default_atom_factory<typename TNode::string> >
+class node_sink_handler
+{
+public:
+    using allocator_type = typename TNode::allocator_type;
+
+    explicit node_sink_handler(TSink sink, TAtomFactory makeAtom = TAtomFactory(),
+            const allocator_type &alloc = allocator_type())
+        : mSink(std::move(sink))
+        , mBuilder(std::move(makeAtom), alloc)
+    {
+    }
+
+    void begin_list()
+    {
+        mBuilder.begin_list();
+    }
+    void end_list()
+    {
+        mBuilder.end_list();
+        flush();
+    }
+    void atom(std::string_view value, bool escaped)
+    {
+        mBuilder.atom(value, escaped);
+        flush();
+    }
+
+    std::size_t depth() const noexcept
+    {
+        return mBuilder.depth();
+    }
+
+private:
+    void flush()
+    {
+        if (!mBuilder.depth())
+        {
+            auto &values = mBuilder.values();
+            TNode value(std::move(values.back()));
+            values.pop_back();
+            mSink(std::move(value));
+        }
+    }
+
+    TSink mSink;
+    tree_builder<TNode, TAtomFactory> mBuilder;
+};
+
+// push parser which calls sink(TNode &&) for every complete top level value
+template< class TNode = node, class TSink >
+inline push_parser<node_sink_handler<TNode, TSink>> make_node_parser(TSink sink,
+    const typename TNode::allocator_type &alloc = typename TNode::allocator_type())
+{
+    return push_parser<node_sink_handler<TNode, TSink>>(
+        node_sink_handler<TNode, TSink>(std::move(sink), {}, alloc));
+}
+
+}
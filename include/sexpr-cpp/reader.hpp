@@ -0,0 +1,271 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <string>
+#include <utility>
+#include <stdexcept>
+#include <string_view>
+
+#include <sexpr-cpp/scanner.hpp>
+
+
+namespace sexpr
+{
+
+class parse_error
+    : public std::runtime_error
+{
+public:
+    parse_error(const char *what, std::size_t offset)
+        : std::runtime_error(what)
+        , mOffset(offset)
+    {
+    }
+
+    std::size_t offset() const noexcept
+    {
+        return mOffset;
+    }
+
+private:
+    std::size_t mOffset;
+};
+
+
+enum class event_type
+{
+    list_begin = 0,
+    list_end = 1,
+    atom = 2,
+    end_of_input = 3,
+};
+
+struct event
+{
+    event_type type;
+    // atoms: the atom text without the surrounding quotes
+    // lists: the parenthesis within the input
+    std::string_view value;
+    // value still contains backslash escape sequences, see unescape()
+    bool escaped;
+};
+
+
+inline void unescape(std::string_view raw, std::string &out)
+{
+    out.reserve(out.size() + raw.size());
+    for (auto it = raw.begin(), end = raw.end(); it != end; ++it)
+    {
+        if (*it != '\\')
+        {
+            out.push_back(*it);
+            continue;
+        }
+        if (++it == end)
+        {
+            out.push_back('\\');
+            break;
+        }
+        switch (*it)
+        {
+        case 'n': out.push_back('\n'); break;
+        case 't': out.push_back('\t'); break;
+        case 'r': out.push_back('\r'); break;
+        case '0': out.push_back('\0'); break;
+        default: out.push_back(*it); break;
+        }
+    }
+}
+
+inline std::string unescape(std::string_view raw)
+{
+    std::string out;
+    unescape(raw, out);
+    return out;
+}
+
+
+// pull parser which tokenizes a contiguous buffer without allocating;
+// atoms are handed out as views into the buffer. The input is classified
+// in 64 byte blocks (see block_scanner) and only structural positions are
+// visited.
+class reader
+{
+public:
+    reader() noexcept
+        : reader(nullptr, nullptr)
+    {
+    }
+    reader(const char *first, const char *last) noexcept
+        : mFirst(first)
+        , mPos(first)
+        , mLast(last)
+        , mDepth(0)
+        , mScan(first, last)
+    {
+    }
+    explicit reader(std::string_view input) noexcept
+        : reader(input.data(), input.data() + input.size())
+    {
+    }
+
+    event next()
+    {
+        mPos = mScan.skip_space(mPos);
+        if (mPos == mLast)
+        {
+            if (mDepth)
+            {
+                throw parse_error("unexpected end of input within a list", offset());
+            }
+            return { event_type::end_of_input, { mPos, 0 }, false };
+        }
+
+        const char *start = mPos;
+        switch (*mPos)
+        {
+        case '(':
+            ++mDepth;
+            ++mPos;
+            return { event_type::list_begin, { start, 1 }, false };
+
+        case ')':
+            if (!mDepth)
+            {
+                throw parse_error("unbalanced closing parenthesis", offset());
+            }
+            --mDepth;
+            ++mPos;
+            return { event_type::list_end, { start, 1 }, false };
+
+        case '"':
+        {
+            bool escaped = false;
+            auto end = mScan.find_quote_end(start + 1, escaped);
+            if (end == mLast)
+            {
+                throw parse_error("unterminated quoted atom", offset());
+            }
+            mPos = end + 1;
+            return { event_type::atom,
+                { start + 1, static_cast<std::size_t>(end - start - 1) }, escaped };
+        }
+
+        default:
+            mPos = mScan.find_atom_end(start);
+            return { event_type::atom,
+                { start, static_cast<std::size_t>(mPos - start) }, false };
+        }
+    }
+
+    // skips the remainder of the innermost open list and
+    // returns the event of its closing parenthesis
+    event skip()
+    {
+        if (!mDepth)
+        {
+            throw std::domain_error("reader::skip() can only be used within a list");
+        }
+
+        const auto target = mDepth - 1;
+        for (;;)
+        {
+            mPos = mScan.find_list_token(mPos);
+            if (mPos == mLast)
+            {
+                throw parse_error("unexpected end of input within a list", offset());
+            }
+
+            const char *start = mPos++;
+            if (*start == '(')
+            {
+                ++mDepth;
+            }
+            else if (*start == ')')
+            {
+                if (--mDepth == target)
+                {
+                    return { event_type::list_end, { start, 1 }, false };
+                }
+            }
+            else
+            {
+                bool escaped = false;
+                mPos = mScan.find_quote_end(mPos, escaped);
+                if (mPos == mLast)
+                {
+                    throw parse_error("unterminated quoted atom", start - mFirst);
+                }
+                ++mPos;
+            }
+        }
+    }
+
+    std::size_t depth() const noexcept
+    {
+        return mDepth;
+    }
+    std::size_t offset() const noexcept
+    {
+        return static_cast<std::size_t>(mPos - mFirst);
+    }
+
+private:
+    const char *mFirst;
+    const char *mPos;
+    const char *mLast;
+    std::size_t mDepth;
+    block_scanner mScan;
+};
+
+
+namespace detail
+{
+template< class THandler >
+inline void dispatch(const event &e, THandler &handler)
+{
+    switch (e.type)
+    {
+    case event_type::list_begin:
+        handler.begin_list();
+        break;
+
+    case event_type::list_end:
+        handler.end_list();
+        break;
+
+    case event_type::atom:
+        handler.atom(e.value, e.escaped);
+        break;
+
+    case event_type::end_of_input:
+        break;
+    }
+}
+}
+
+// push interface on top of reader; the handler has to provide
+//     begin_list(), end_list() and atom(std::string_view value, bool escaped)
+template< class THandler >
+inline void read_events(const char *first, const char *last, THandler &&handler)
+{
+    reader r(first, last);
+    for (auto e = r.next(); e.type != event_type::end_of_input; e = r.next())
+    {
+        detail::dispatch(e, handler);
+    }
+}
+
+template< class THandler >
+inline void read_events(std::string_view input, THandler &&handler)
+{
+    read_events(input.data(), input.data() + input.size(), std::forward<THandler>(handler));
+}
+
+}
@@ -0,0 +1,331 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(SEXPR_CPP_NO_SIMD)
+#if defined(__x86_64__) || defined(_M_X64) \
+    || ((defined(__i386__) || defined(_M_IX86)) && (defined(__SSE2__) || _M_IX86_FP >= 2))
+#define SEXPR_CPP_HAS_SSE2 1
+#define SEXPR_CPP_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(SEXPR_CPP_HAS_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#define SEXPR_CPP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SEXPR_CPP_TARGET_AVX2
+#endif
+
+
+namespace sexpr
+{
+
+// structural bitmasks of a 64 byte block, bit i corresponds to byte i
+struct block_masks
+{
+    std::uint64_t open;
+    std::uint64_t close;
+    std::uint64_t quote;
+    std::uint64_t escape;
+    std::uint64_t space;
+};
+
+
+namespace detail
+{
+constexpr std::size_t block_size = 64;
+
+constexpr bool is_space(char c) noexcept
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+constexpr bool is_delimiter(char c) noexcept
+{
+    return is_space(c) || c == '(' || c == ')' || c == '"';
+}
+
+inline unsigned count_trailing_zeros(std::uint64_t v) noexcept
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return static_cast<unsigned>(idx);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    if (_BitScanForward(&idx, static_cast<unsigned long>(v)))
+    {
+        return static_cast<unsigned>(idx);
+    }
+    _BitScanForward(&idx, static_cast<unsigned long>(v >> 32));
+    return static_cast<unsigned>(idx) + 32;
+#else
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+}
+
+
+inline void classify_scalar(const char *block, block_masks &masks) noexcept
+{
+    masks = block_masks{};
+    for (std::size_t i = 0; i < block_size; ++i)
+    {
+        const std::uint64_t bit = std::uint64_t{ 1 } << i;
+        switch (block[i])
+        {
+        case '(': masks.open |= bit; break;
+        case ')': masks.close |= bit; break;
+        case '"': masks.quote |= bit; break;
+        case '\\': masks.escape |= bit; break;
+        default:
+            if (is_space(block[i]))
+            {
+                masks.space |= bit;
+            }
+            break;
+        }
+    }
+}
+
+#if defined(SEXPR_CPP_HAS_SSE2)
+inline std::uint64_t sse2_mask(__m128i m) noexcept
+{
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(m)));
+}
+
+inline void classify_sse2(const char *block, block_masks &masks) noexcept
+{
+    const __m128i open = _mm_set1_epi8('(');
+    const __m128i close = _mm_set1_epi8(')');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i escape = _mm_set1_epi8('\\');
+    const __m128i blank = _mm_set1_epi8(' ');
+    const __m128i ctrl_lo = _mm_set1_epi8('\t' - 1);
+    const __m128i ctrl_hi = _mm_set1_epi8('\r' + 1);
+
+    masks = block_masks{};
+    for (unsigned i = 0; i < block_size; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+        const __m128i ctrl = _mm_and_si128(_mm_cmpgt_epi8(v, ctrl_lo), _mm_cmplt_epi8(v, ctrl_hi));
+
+        masks.open |= sse2_mask(_mm_cmpeq_epi8(v, open)) << i;
+        masks.close |= sse2_mask(_mm_cmpeq_epi8(v, close)) << i;
+        masks.quote |= sse2_mask(_mm_cmpeq_epi8(v, quote)) << i;
+        masks.escape |= sse2_mask(_mm_cmpeq_epi8(v, escape)) << i;
+        masks.space |= sse2_mask(_mm_or_si128(_mm_cmpeq_epi8(v, blank), ctrl)) << i;
+    }
+}
+#endif
+
+#if defined(SEXPR_CPP_HAS_AVX2)
+SEXPR_CPP_TARGET_AVX2
+inline std::uint64_t avx2_mask(__m256i m) noexcept
+{
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(m)));
+}
+
+SEXPR_CPP_TARGET_AVX2
+inline std::uint64_t avx2_match(__m256i lo, __m256i hi, char c) noexcept
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    return avx2_mask(_mm256_cmpeq_epi8(lo, needle))
+        | avx2_mask(_mm256_cmpeq_epi8(hi, needle)) << 32;
+}
+
+SEXPR_CPP_TARGET_AVX2
+inline std::uint64_t avx2_space(__m256i v) noexcept
+{
+    const __m256i ctrl = _mm256_and_si256(
+        _mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v));
+    return avx2_mask(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), ctrl));
+}
+
+SEXPR_CPP_TARGET_AVX2
+inline void classify_avx2(const char *block, block_masks &masks) noexcept
+{
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+
+    masks.open = avx2_match(lo, hi, '(');
+    masks.close = avx2_match(lo, hi, ')');
+    masks.quote = avx2_match(lo, hi, '"');
+    masks.escape = avx2_match(lo, hi, '\\');
+    masks.space = avx2_space(lo) | avx2_space(hi) << 32;
+}
+
+inline bool cpu_has_avx2() noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    // the os must save the ymm registers (osxsave + avx)
+    if ((info[2] & 0x18000000) != 0x18000000 || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & 0x20) != 0;
+#else
+    return false;
+#endif
+}
+#else
+inline bool cpu_has_avx2() noexcept
+{
+    return false;
+}
+#endif
+
+
+using classify_fn = void (*)(const char *, block_masks &) noexcept;
+
+inline classify_fn select_classifier() noexcept
+{
+#if defined(SEXPR_CPP_HAS_AVX2)
+    if (cpu_has_avx2())
+    {
+        return &classify_avx2;
+    }
+#endif
+#if defined(SEXPR_CPP_HAS_SSE2)
+    return &classify_sse2;
+#else
+    return &classify_scalar;
+#endif
+}
+
+// the best kernel available on the executing cpu, determined once
+inline classify_fn classifier() noexcept
+{
+    static const classify_fn fn = select_classifier();
+    return fn;
+}
+}
+
+
+// stage two of the tokenizer: walks the structural bitmasks of the
+// current 64 byte block instead of looking at each byte
+class block_scanner
+{
+public:
+    block_scanner(const char *first, const char *last) noexcept
+        : mFirst(first)
+        , mLast(last)
+        , mBlock(nullptr)
+        , mMasks()
+        , mClassify(detail::classifier())
+    {
+    }
+
+    const char * skip_space(const char *pos) noexcept
+    {
+        return find(pos, [](const block_masks &m) { return ~m.space; });
+    }
+    const char * find_atom_end(const char *pos) noexcept
+    {
+        return find(pos, [](const block_masks &m)
+        {
+            return m.space | m.open | m.close | m.quote;
+        });
+    }
+    const char * find_list_token(const char *pos) noexcept
+    {
+        return find(pos, [](const block_masks &m) { return m.open | m.close | m.quote; });
+    }
+    const char * find_quote_or_escape(const char *pos) noexcept
+    {
+        return find(pos, [](const block_masks &m) { return m.quote | m.escape; });
+    }
+    // returns the position of the closing quote or last if there is none
+    const char * find_quote_end(const char *pos, bool &escaped) noexcept
+    {
+        for (;;)
+        {
+            pos = find_quote_or_escape(pos);
+            if (pos == mLast || *pos == '"')
+            {
+                return pos;
+            }
+            escaped = true;
+            if (mLast - pos <= 2)
+            {
+                return mLast;
+            }
+            pos += 2;
+        }
+    }
+
+private:
+    template< class TSelect >
+    const char * find(const char *pos, TSelect select) noexcept
+    {
+        while (pos < mLast)
+        {
+            load(pos);
+            const auto shift = static_cast<unsigned>(pos - mBlock);
+            if (const auto bits = select(mMasks) & (~std::uint64_t{ 0 } << shift))
+            {
+                const char *hit = mBlock + detail::count_trailing_zeros(bits);
+                return hit < mLast ? hit : mLast;
+            }
+            pos = mBlock + detail::block_size;
+        }
+        return mLast;
+    }
+
+    void load(const char *pos) noexcept
+    {
+        const auto offset = static_cast<std::size_t>(pos - mFirst);
+        const char *block = mFirst + (offset & ~(detail::block_size - 1));
+        if (block == mBlock)
+        {
+            return;
+        }
+
+        mBlock = block;
+        const auto remaining = static_cast<std::size_t>(mLast - block);
+        if (remaining >= detail::block_size)
+        {
+            mClassify(block, mMasks);
+        }
+        else
+        {
+            // the padding is classified as whitespace which terminates
+            // any pending atom exactly at the end of the input
+            char tail[detail::block_size];
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, remaining);
+            mClassify(tail, mMasks);
+        }
+    }
+
+    const char *mFirst;
+    const char *mLast;
+    const char *mBlock;
+    block_masks mMasks;
+    detail::classify_fn mClassify;
+};
+
+}
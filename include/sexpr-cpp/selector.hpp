@@ -0,0 +1,193 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/reader.hpp>
+
+
+namespace sexpr
+{
+
+// compiled path query over lists which are identified by their head atom
+//
+// The query (config server * port) matches every list headed by port
+// which is a child of a list headed by any atom, which is a child of a
+// list headed by server, which is a child of the root list headed by
+// config. The atom * matches any head atom.
+class selector
+{
+public:
+    explicit selector(std::string_view query)
+        : mSteps()
+    {
+        reader r(query);
+        auto e = r.next();
+        if (e.type != event_type::list_begin)
+        {
+            throw std::domain_error("a selector must be a list of atoms");
+        }
+        for (e = r.next(); e.type == event_type::atom; e = r.next())
+        {
+            auto head = e.escaped ? unescape(e.value) : std::string(e.value);
+            const bool any = head == "*";
+            mSteps.push_back({ std::move(head), any });
+        }
+        if (e.type != event_type::list_end || mSteps.empty())
+        {
+            throw std::domain_error("a selector must be a non-empty list of atoms");
+        }
+        if (r.next().type != event_type::end_of_input)
+        {
+            throw std::domain_error("unexpected characters after the selector");
+        }
+    }
+
+    // number of path steps
+    std::size_t size() const noexcept
+    {
+        return mSteps.size();
+    }
+
+    // calls f(const TNode &) for every match in document order
+    template< class TNode, class TFunc >
+    void for_each(const TNode &root, TFunc &&f) const
+    {
+        match(root, 0, f);
+    }
+
+    template< class TNode >
+    std::vector<const TNode *> select(const TNode &root) const
+    {
+        std::vector<const TNode *> matches;
+        for_each(root, [&matches](const TNode &n) { matches.push_back(&n); });
+        return matches;
+    }
+
+    // runs the query against every top level expression of the input and
+    // calls f(std::string_view) with the text of every matching list
+    //
+    // no nodes are built and lists whose head can't match are skipped
+    // without looking at their atoms.
+    template< class TFunc >
+    void scan(reader &r, TFunc &&f) const
+    {
+        std::string scratch;
+        for (auto e = r.next(); e.type != event_type::end_of_input; e = r.next())
+        {
+            if (e.type == event_type::list_begin)
+            {
+                match(r, e.value.data(), 0, scratch, f);
+            }
+        }
+    }
+    template< class TFunc >
+    void scan(std::string_view input, TFunc &&f) const
+    {
+        reader r(input);
+        scan(r, std::forward<TFunc>(f));
+    }
+
+private:
+    struct step
+    {
+        std::string head;
+        bool any;
+    };
+
+    bool matches(std::size_t idx, std::string_view head) const noexcept
+    {
+        const auto &s = mSteps[idx];
+        return s.any || head == s.head;
+    }
+
+    // the recursion depth is bounded by the number of steps
+    template< class TNode, class TFunc >
+    void match(const TNode &n, std::size_t idx, TFunc &f) const
+    {
+        if (!n.is_list() || n.empty())
+        {
+            return;
+        }
+        const auto &head = n.front();
+        if (!head.is_string())
+        {
+            return;
+        }
+        const auto &text = head.get_string();
+        if (!matches(idx, std::string_view(text.data(), text.size())))
+        {
+            return;
+        }
+
+        if (idx + 1 == mSteps.size())
+        {
+            f(n);
+            return;
+        }
+        for (auto it = std::next(n.begin()), end = n.end(); it != end; ++it)
+        {
+            match(*it, idx + 1, f);
+        }
+    }
+
+    // the opening parenthesis has already been consumed
+    template< class TFunc >
+    void match(reader &r, const char *open, std::size_t idx, std::string &scratch, TFunc &f) const
+    {
+        auto e = r.next();
+        if (e.type == event_type::list_end)
+        {
+            return;
+        }
+        if (e.type == event_type::list_begin)
+        {
+            r.skip();
+            r.skip();
+            return;
+        }
+
+        auto head = e.value;
+        if (e.escaped)
+        {
+            scratch.clear();
+            unescape(head, scratch);
+            head = scratch;
+        }
+        if (!matches(idx, head))
+        {
+            r.skip();
+            return;
+        }
+
+        if (idx + 1 == mSteps.size())
+        {
+            const auto close = r.skip();
+            f(std::string_view(open, static_cast<std::size_t>(close.value.data() + 1 - open)));
+            return;
+        }
+        for (e = r.next(); e.type != event_type::list_end; e = r.next())
+        {
+            if (e.type == event_type::list_begin)
+            {
+                match(r, e.value.data(), idx + 1, scratch, f);
+            }
+        }
+    }
+
+    std::vector<step> mSteps;
+};
+
+}
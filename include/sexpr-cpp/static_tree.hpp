@@ -0,0 +1,283 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <stdexcept>
+#include <string_view>
+
+#include <sexpr-cpp/reader.hpp>
+#include <sexpr-cpp/scanner.hpp>
+#include <sexpr-cpp/tape.hpp>
+
+
+namespace sexpr
+{
+
+namespace detail
+{
+// same mapping as unescape()
+constexpr char static_unescape_char(char c) noexcept
+{
+    switch (c)
+    {
+    case 'n': return '\n';
+    case 't': return '\t';
+    case 'r': return '\r';
+    case '0': return '\0';
+    default: return c;
+    }
+}
+
+constexpr std::size_t static_unescaped_size(std::string_view raw) noexcept
+{
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < raw.size(); ++i, ++size)
+    {
+        if (raw[i] == '\\')
+        {
+            ++i;
+        }
+    }
+    return size;
+}
+
+constexpr std::size_t static_unescape(std::string_view raw, char *out) noexcept
+{
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < raw.size(); ++i)
+    {
+        char c = raw[i];
+        if (c == '\\' && ++i < raw.size())
+        {
+            c = static_unescape_char(raw[i]);
+        }
+        out[size++] = c;
+    }
+    return size;
+}
+
+// byte wise parser which can be evaluated at compile time; feeds exactly
+// one expression to the handler. Throwing within a constant expression
+// turns syntax errors into compile errors.
+template< class THandler >
+constexpr void static_parse(std::string_view input, THandler &handler)
+{
+    std::size_t depth = 0;
+    std::size_t pos = 0;
+    bool done = false;
+    for (;;)
+    {
+        while (pos < input.size() && is_space(input[pos]))
+        {
+            ++pos;
+        }
+        if (pos == input.size())
+        {
+            if (depth)
+            {
+                throw parse_error("unexpected end of input within a list", pos);
+            }
+            if (!done)
+            {
+                throw parse_error("the input doesn't contain an expression", pos);
+            }
+            return;
+        }
+        if (done)
+        {
+            throw parse_error("unexpected characters after the expression", pos);
+        }
+
+        const std::size_t start = pos;
+        switch (input[pos])
+        {
+        case '(':
+            ++depth;
+            ++pos;
+            handler.begin_list();
+            break;
+
+        case ')':
+            if (!depth)
+            {
+                throw parse_error("unbalanced closing parenthesis", pos);
+            }
+            --depth;
+            ++pos;
+            handler.end_list();
+            break;
+
+        case '"':
+        {
+            bool escaped = false;
+            for (++pos; pos < input.size() && input[pos] != '"'; ++pos)
+            {
+                if (input[pos] == '\\')
+                {
+                    escaped = true;
+                    ++pos;
+                }
+            }
+            if (pos >= input.size())
+            {
+                throw parse_error("unterminated quoted atom", start);
+            }
+            handler.atom(input.substr(start + 1, pos - start - 1), escaped);
+            ++pos;
+            break;
+        }
+
+        default:
+            while (pos < input.size() && !is_delimiter(input[pos]))
+            {
+                ++pos;
+            }
+            handler.atom(input.substr(start, pos - start), false);
+            break;
+        }
+        done = !depth;
+    }
+}
+
+struct static_extent
+{
+    std::size_t entries = 0;
+    std::size_t atoms = 0;
+
+    constexpr void begin_list() noexcept
+    {
+        entries += 2;
+    }
+    constexpr void end_list() noexcept
+    {
+    }
+    constexpr void atom(std::string_view value, bool escaped) noexcept
+    {
+        entries += 1;
+        atoms += escaped ? static_unescaped_size(value) : value.size();
+    }
+};
+
+// number of tape entries and atom characters required for the expression
+constexpr static_extent static_extent_of(std::string_view input)
+{
+    static_extent extent;
+    static_parse(input, extent);
+    return extent;
+}
+
+// records the events on preallocated arrays; the matching list_begin and
+// the number of children are recovered by walking back over the siblings
+class static_tape_writer
+{
+public:
+    constexpr static_tape_writer(tape_entry *entries, char *atoms) noexcept
+        : mEntries(entries)
+        , mAtoms(atoms)
+        , mNumEntries(0)
+        , mNumAtoms(0)
+    {
+    }
+
+    constexpr void begin_list() noexcept
+    {
+        mEntries[mNumEntries++] = tape_entry::make(tape_tag::list_begin, 0, 0);
+    }
+    constexpr void end_list() noexcept
+    {
+        std::size_t begin = mNumEntries;
+        std::uint64_t children = 0;
+        for (;;)
+        {
+            const auto &e = mEntries[--begin];
+            if (e.tag() == tape_tag::list_begin)
+            {
+                break;
+            }
+            ++children;
+            if (e.tag() == tape_tag::list_end)
+            {
+                begin = e.payload();
+            }
+        }
+        mEntries[begin] = tape_entry::make(tape_tag::list_begin, mNumEntries, children);
+        mEntries[mNumEntries++] = tape_entry::make(tape_tag::list_end, begin, 0);
+    }
+    constexpr void atom(std::string_view value, bool escaped) noexcept
+    {
+        std::size_t size = value.size();
+        if (escaped)
+        {
+            size = static_unescape(value, mAtoms + mNumAtoms);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                mAtoms[mNumAtoms + i] = value[i];
+            }
+        }
+        mEntries[mNumEntries++] = tape_entry::make(tape_tag::atom, mNumAtoms, size);
+        mNumAtoms += size;
+    }
+
+private:
+    tape_entry *mEntries;
+    char *mAtoms;
+    std::size_t mNumEntries;
+    std::size_t mNumAtoms;
+};
+}
+
+
+// tape with a fixed size which can be built at compile time and lives in
+// static storage, i.e. it needs neither allocations nor initialization
+// at runtime; use SEXPR_LITERAL() to deduce the sizes
+template< std::size_t NumEntries, std::size_t NumAtoms >
+class static_tree
+{
+public:
+    constexpr explicit static_tree(std::string_view input)
+        : mEntries{}
+        , mAtoms{}
+    {
+        const auto extent = detail::static_extent_of(input);
+        if (extent.entries != NumEntries || extent.atoms != NumAtoms)
+        {
+            throw std::domain_error("the static_tree size doesn't match the expression");
+        }
+        detail::static_tape_writer writer(mEntries, mAtoms);
+        detail::static_parse(input, writer);
+    }
+
+    constexpr tape_cursor root() const noexcept
+    {
+        return tape_cursor(mEntries, mAtoms, 0);
+    }
+
+private:
+    tape_entry mEntries[NumEntries];
+    // never empty
+    char mAtoms[NumAtoms + 1];
+};
+
+}
+
+
+// evaluates to a tape_cursor of the expression which is parsed and checked
+// at compile time; the tree is stored in static storage
+#define SEXPR_LITERAL(text) \
+    ([]() noexcept -> ::sexpr::tape_cursor \
+    { \
+        constexpr ::std::string_view sexpr_literal_text_(text); \
+        constexpr auto sexpr_literal_extent_ = ::sexpr::detail::static_extent_of(sexpr_literal_text_); \
+        static constexpr ::sexpr::static_tree<sexpr_literal_extent_.entries, sexpr_literal_extent_.atoms> \
+            sexpr_literal_tree_(sexpr_literal_text_); \
+        return sexpr_literal_tree_.root(); \
+    }())
@@ -0,0 +1,274 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <functional>
+#include <string_view>
+#include <shared_mutex>
+#include <unordered_map>
+#include <memory_resource>
+
+#include <sexpr-cpp/data.hpp>
+
+
+namespace sexpr
+{
+
+class symbol_table;
+
+namespace detail
+{
+struct symbol_data
+{
+    // null terminated
+    std::string_view text;
+    std::size_t hash;
+    const symbol_table *table;
+};
+
+inline const symbol_data * empty_symbol() noexcept
+{
+    static const symbol_data empty{ std::string_view("", 0), std::hash<std::string_view>()({}), nullptr };
+    return &empty;
+}
+}
+
+
+// stores each distinct text exactly once; interned texts live as long as
+// the table. Lookups of already interned texts only take a shared lock, so
+// concurrent readers don't block each other.
+class symbol_table
+{
+public:
+    symbol_table()
+        : mMutex()
+        , mArena()
+        , mData()
+        , mIndex()
+    {
+    }
+    symbol_table(const symbol_table &) = delete;
+    symbol_table & operator=(const symbol_table &) = delete;
+
+    // the table shared by all symbols which aren't bound to a specific table
+    static symbol_table & global()
+    {
+        static symbol_table table;
+        return table;
+    }
+
+    const detail::symbol_data * intern(std::string_view text)
+    {
+        if (auto data = find(text))
+        {
+            return data;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mMutex);
+        auto it = mIndex.find(text);
+        if (it != mIndex.end())
+        {
+            return it->second;
+        }
+
+        auto storage = static_cast<char *>(mArena.allocate(text.size() + 1, 1));
+        std::memcpy(storage, text.data(), text.size());
+        storage[text.size()] = '\0';
+        std::string_view stored(storage, text.size());
+
+        mData.push_back({ stored, std::hash<std::string_view>()(stored), this });
+        mIndex.emplace(stored, &mData.back());
+        return &mData.back();
+    }
+
+    // returns nullptr if text hasn't been interned yet
+    const detail::symbol_data * find(std::string_view text) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mMutex);
+        auto it = mIndex.find(text);
+        return it != mIndex.end() ? it->second : nullptr;
+    }
+
+    std::size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mMutex);
+        return mData.size();
+    }
+
+private:
+    mutable std::shared_mutex mMutex;
+    std::pmr::monotonic_buffer_resource mArena;
+    std::deque<detail::symbol_data> mData;
+    std::unordered_map<std::string_view, const detail::symbol_data *> mIndex;
+};
+
+
+// immutable handle to an interned text which can be used as the string
+// type of basic_node; copying, equality and hashing are O(1)
+class symbol
+{
+public:
+    using value_type = char;
+    using size_type = std::size_t;
+    using const_iterator = const char *;
+    using iterator = const_iterator;
+
+    symbol() noexcept
+        : mData(detail::empty_symbol())
+    {
+    }
+    symbol(const char *str, size_type n)
+        : symbol(std::string_view(str, n))
+    {
+    }
+    explicit symbol(std::string_view text)
+        : symbol(text, symbol_table::global())
+    {
+    }
+    symbol(std::string_view text, symbol_table &table)
+        : mData(table.intern(text))
+    {
+    }
+
+    const char * data() const noexcept
+    {
+        return mData->text.data();
+    }
+    const char * c_str() const noexcept
+    {
+        return mData->text.data();
+    }
+    size_type size() const noexcept
+    {
+        return mData->text.size();
+    }
+    size_type length() const noexcept
+    {
+        return mData->text.size();
+    }
+    bool empty() const noexcept
+    {
+        return mData->text.empty();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return data();
+    }
+    const_iterator end() const noexcept
+    {
+        return data() + size();
+    }
+
+    std::string_view view() const noexcept
+    {
+        return mData->text;
+    }
+    operator std::string_view() const noexcept
+    {
+        return mData->text;
+    }
+    std::string str() const
+    {
+        return std::string(mData->text);
+    }
+
+    // the hash of the text as computed by std::hash<std::string_view>
+    std::size_t hash() const noexcept
+    {
+        return mData->hash;
+    }
+    // nullptr for the empty symbol of a default constructed instance
+    const symbol_table * table() const noexcept
+    {
+        return mData->table;
+    }
+
+    void clear() noexcept
+    {
+        mData = detail::empty_symbol();
+    }
+    void swap(symbol &other) noexcept
+    {
+        std::swap(mData, other.mData);
+    }
+
+    int compare(const symbol &other) const noexcept
+    {
+        return mData == other.mData ? 0 : mData->text.compare(other.mData->text);
+    }
+
+    friend bool operator==(const symbol &lhs, const symbol &rhs) noexcept
+    {
+        // distinct symbols of the same table always differ
+        return lhs.mData == rhs.mData
+            || (lhs.mData->table != rhs.mData->table && lhs.mData->text == rhs.mData->text);
+    }
+    friend bool operator!=(const symbol &lhs, const symbol &rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+    friend bool operator<(const symbol &lhs, const symbol &rhs) noexcept
+    {
+        return lhs.compare(rhs) < 0;
+    }
+
+    friend bool operator==(const symbol &lhs, std::string_view rhs) noexcept
+    {
+        return lhs.view() == rhs;
+    }
+    friend bool operator!=(const symbol &lhs, std::string_view rhs) noexcept
+    {
+        return lhs.view() != rhs;
+    }
+
+private:
+    const detail::symbol_data *mData;
+};
+
+inline void swap(symbol &lhs, symbol &rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+inline std::ostream & operator<<(std::ostream &os, const symbol &s)
+{
+    return os << s.view();
+}
+
+
+struct symbol_traits
+{
+    static int compare(const symbol &lhs, const symbol &rhs) noexcept
+    {
+        return lhs.compare(rhs);
+    }
+};
+
+using symbol_node = basic_node<symbol, std::vector, symbol_traits>;
+
+}
+
+
+namespace std
+{
+template<>
+struct hash<sexpr::symbol>
+{
+    std::size_t operator()(const sexpr::symbol &s) const noexcept
+    {
+        return s.hash();
+    }
+};
+}
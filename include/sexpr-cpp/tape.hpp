@@ -0,0 +1,605 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/reader.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+
+namespace sexpr
+{
+
+enum class tape_tag : std::uint8_t
+{
+    list_begin = 0,
+    list_end = 1,
+    atom = 2,
+};
+
+// a single tape entry; the tag lives in the top byte of the first word
+//     list_begin: index of the matching list_end | number of children
+//     list_end:   index of the matching list_begin | 0
+//     atom:       offset into the atom arena | length
+struct tape_entry
+{
+    static constexpr unsigned tag_shift = 56;
+    static constexpr std::uint64_t payload_mask = (std::uint64_t{ 1 } << tag_shift) - 1;
+
+    std::uint64_t word;
+    std::uint64_t extra;
+
+    static constexpr tape_entry make(tape_tag tag, std::uint64_t payload, std::uint64_t extra) noexcept
+    {
+        return { static_cast<std::uint64_t>(tag) << tag_shift | (payload & payload_mask), extra };
+    }
+
+    constexpr tape_tag tag() const noexcept
+    {
+        return static_cast<tape_tag>(word >> tag_shift);
+    }
+    constexpr std::uint64_t payload() const noexcept
+    {
+        return word & payload_mask;
+    }
+};
+
+
+// read only view of a value stored on a tape; mirrors the read interface
+// of basic_node, but children are handed out by value
+class tape_cursor
+{
+public:
+    using type = node_type;
+    using value_type = tape_cursor;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = tape_cursor;
+    using const_reference = tape_cursor;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = tape_cursor;
+        using difference_type = std::ptrdiff_t;
+        using reference = tape_cursor;
+
+        struct pointer;
+
+        constexpr const_iterator() noexcept
+            : mEntries(nullptr)
+            , mAtoms(nullptr)
+            , mIndex(0)
+        {
+        }
+        constexpr const_iterator(const tape_entry *entries, const char *atoms, std::size_t index) noexcept
+            : mEntries(entries)
+            , mAtoms(atoms)
+            , mIndex(index)
+        {
+        }
+
+        constexpr reference operator*() const noexcept;
+        constexpr pointer operator->() const noexcept;
+
+        constexpr const_iterator & operator++() noexcept;
+        constexpr const_iterator operator++(int) noexcept;
+
+        friend constexpr bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        {
+            return lhs.mEntries == rhs.mEntries && lhs.mIndex == rhs.mIndex;
+        }
+        friend constexpr bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        const tape_entry *mEntries;
+        const char *mAtoms;
+        std::size_t mIndex;
+    };
+    using iterator = const_iterator;
+
+
+    constexpr tape_cursor() noexcept
+        : mEntries(nullptr)
+        , mAtoms(nullptr)
+        , mIndex(0)
+    {
+    }
+    constexpr tape_cursor(const tape_entry *entries, const char *atoms, std::size_t index) noexcept
+        : mEntries(entries)
+        , mAtoms(atoms)
+        , mIndex(index)
+    {
+    }
+
+    constexpr type which() const noexcept
+    {
+        return entry().tag() == tape_tag::atom ? node_type::string : node_type::list;
+    }
+    constexpr bool is_list() const noexcept
+    {
+        return which() == node_type::list;
+    }
+    constexpr bool is_string() const noexcept
+    {
+        return which() == node_type::string;
+    }
+
+    constexpr std::string_view get_string() const
+    {
+        if (!is_string())
+        {
+            throw std::domain_error("tape_cursor::get_string() can only be used with strings");
+        }
+        return { mAtoms + entry().payload(), static_cast<std::size_t>(entry().extra) };
+    }
+
+    constexpr const_iterator begin() const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("tape_cursor::begin can only be used with lists");
+        }
+        return { mEntries, mAtoms, mIndex + 1 };
+    }
+    constexpr const_iterator cbegin() const
+    {
+        return begin();
+    }
+    constexpr const_iterator end() const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("tape_cursor::end can only be used with lists");
+        }
+        return { mEntries, mAtoms, static_cast<std::size_t>(entry().payload()) };
+    }
+    constexpr const_iterator cend() const
+    {
+        return end();
+    }
+
+    // linear in idx, but lists are skipped as a whole
+    constexpr tape_cursor operator[](size_type idx) const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("tape_cursor::operator[] can only be used with lists");
+        }
+        auto it = begin();
+        for (; idx; --idx)
+        {
+            ++it;
+        }
+        return *it;
+    }
+    constexpr tape_cursor at(size_type idx) const
+    {
+        if (!is_list())
+        {
+            throw std::domain_error("tape_cursor::at() can only be used with lists");
+        }
+        if (idx >= size())
+        {
+            throw std::out_of_range("tape_cursor::at() index out of range");
+        }
+        return (*this)[idx];
+    }
+
+    constexpr tape_cursor front() const
+    {
+        if (!is_list() || empty())
+        {
+            throw std::domain_error("tape_cursor::front() can only be used with non empty lists");
+        }
+        return *begin();
+    }
+    constexpr tape_cursor back() const
+    {
+        if (!is_list() || empty())
+        {
+            throw std::domain_error("tape_cursor::back() can only be used with non empty lists");
+        }
+        // the entry in front of our list_end is either an atom or the end of the last child
+        const auto last = static_cast<std::size_t>(entry().payload()) - 1;
+        const auto &e = mEntries[last];
+        return { mEntries, mAtoms,
+            e.tag() == tape_tag::list_end ? static_cast<std::size_t>(e.payload()) : last };
+    }
+
+    // lists: number of children, strings: 1
+    constexpr bool empty() const noexcept
+    {
+        return is_list() && entry().extra == 0;
+    }
+    constexpr size_type size() const noexcept
+    {
+        return is_list() ? static_cast<size_type>(entry().extra) : 1;
+    }
+
+    // position of this value on the tape and the number of entries it spans
+    constexpr std::size_t index() const noexcept
+    {
+        return mIndex;
+    }
+    constexpr std::size_t extent() const noexcept
+    {
+        return next_index() - mIndex;
+    }
+
+    constexpr const tape_entry * entries() const noexcept
+    {
+        return mEntries;
+    }
+    constexpr const char * atoms() const noexcept
+    {
+        return mAtoms;
+    }
+
+private:
+    constexpr const tape_entry & entry() const noexcept
+    {
+        return mEntries[mIndex];
+    }
+    constexpr std::size_t next_index() const noexcept
+    {
+        return (is_list() ? static_cast<std::size_t>(entry().payload()) : mIndex) + 1;
+    }
+
+    const tape_entry *mEntries;
+    const char *mAtoms;
+    std::size_t mIndex;
+};
+
+
+struct tape_cursor::const_iterator::pointer
+{
+    tape_cursor value;
+
+    constexpr const tape_cursor * operator->() const noexcept
+    {
+        return &value;
+    }
+};
+
+inline constexpr tape_cursor tape_cursor::const_iterator::operator*() const noexcept
+{
+    return { mEntries, mAtoms, mIndex };
+}
+inline constexpr tape_cursor::const_iterator::pointer tape_cursor::const_iterator::operator->() const noexcept
+{
+    return { **this };
+}
+inline constexpr tape_cursor::const_iterator & tape_cursor::const_iterator::operator++() noexcept
+{
+    mIndex = (**this).next_index();
+    return *this;
+}
+inline constexpr tape_cursor::const_iterator tape_cursor::const_iterator::operator++(int) noexcept
+{
+    auto tmp = *this;
+    ++*this;
+    return tmp;
+}
+
+
+inline constexpr bool operator==(const tape_cursor &lhs, const tape_cursor &rhs)
+{
+    const auto extent = lhs.extent();
+    if (extent != rhs.extent())
+    {
+        return false;
+    }
+    const auto *l = lhs.entries() + lhs.index();
+    const auto *r = rhs.entries() + rhs.index();
+    for (std::size_t i = 0; i < extent; ++i)
+    {
+        const auto tag = l[i].tag();
+        if (tag != r[i].tag())
+        {
+            return false;
+        }
+        if (tag == tape_tag::atom)
+        {
+            if (tape_cursor(l, lhs.atoms(), i).get_string()
+                != tape_cursor(r, rhs.atoms(), i).get_string())
+            {
+                return false;
+            }
+        }
+        else if (l[i].extra != r[i].extra)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+inline constexpr bool operator!=(const tape_cursor &lhs, const tape_cursor &rhs)
+{
+    return !(lhs == rhs);
+}
+
+
+namespace detail
+{
+template< class T >
+struct is_basic_node
+    : std::false_type
+{
+};
+template< class TString, template<class, class...> class TList, class TStringTraits, class TListTraits >
+struct is_basic_node<basic_node<TString, TList, TStringTraits, TListTraits>>
+    : std::true_type
+{
+};
+
+template< class TNode >
+inline bool equal(const tape_cursor &t, const TNode &n)
+{
+    struct frame
+    {
+        typename TNode::const_iterator it;
+        typename TNode::const_iterator end;
+        tape_cursor::const_iterator cursor;
+    };
+    std::vector<frame> stack;
+
+    tape_cursor lhs = t;
+    const TNode *rhs = &n;
+    for (;;)
+    {
+        if (rhs)
+        {
+            if (lhs.which() != rhs->which())
+            {
+                return false;
+            }
+            if (rhs->is_string())
+            {
+                const auto &s = rhs->get_string();
+                if (lhs.get_string() != std::string_view(s.data(), s.size()))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                if (lhs.size() != rhs->size())
+                {
+                    return false;
+                }
+                stack.push_back({ rhs->cbegin(), rhs->cend(), lhs.cbegin() });
+            }
+            rhs = nullptr;
+        }
+
+        if (stack.empty())
+        {
+            return true;
+        }
+        auto &top = stack.back();
+        if (top.it == top.end)
+        {
+            stack.pop_back();
+            continue;
+        }
+        lhs = *top.cursor++;
+        rhs = &*top.it++;
+    }
+}
+}
+
+template< class TNode, std::enable_if_t<detail::is_basic_node<TNode>::value, int> = 0 >
+inline bool operator==(const tape_cursor &lhs, const TNode &rhs)
+{
+    return detail::equal(lhs, rhs);
+}
+template< class TNode, std::enable_if_t<detail::is_basic_node<TNode>::value, int> = 0 >
+inline bool operator==(const TNode &lhs, const tape_cursor &rhs)
+{
+    return detail::equal(rhs, lhs);
+}
+template< class TNode, std::enable_if_t<detail::is_basic_node<TNode>::value, int> = 0 >
+inline bool operator!=(const tape_cursor &lhs, const TNode &rhs)
+{
+    return !detail::equal(lhs, rhs);
+}
+template< class TNode, std::enable_if_t<detail::is_basic_node<TNode>::value, int> = 0 >
+inline bool operator!=(const TNode &lhs, const tape_cursor &rhs)
+{
+    return !detail::equal(rhs, lhs);
+}
+
+
+// the tape already is in event order
+template< class THandler >
+inline void walk_events(const tape_cursor &t, THandler &&handler)
+{
+    const auto *entries = t.entries();
+    for (std::size_t i = t.index(), last = i + t.extent(); i != last; ++i)
+    {
+        switch (entries[i].tag())
+        {
+        case tape_tag::list_begin:
+            handler.begin_list();
+            break;
+
+        case tape_tag::list_end:
+            handler.end_list();
+            break;
+
+        case tape_tag::atom:
+            handler.atom(tape_cursor(entries, t.atoms(), i).get_string(), false);
+            break;
+        }
+    }
+}
+
+
+class tape_builder;
+
+// immutable expression stored as one contiguous array of entries in
+// depth first order plus a single arena for the atom contents
+class tape
+{
+    friend class tape_builder;
+
+public:
+    // an empty list
+    tape()
+        : mEntries{ tape_entry::make(tape_tag::list_begin, 1, 0),
+            tape_entry::make(tape_tag::list_end, 0, 0) }
+        , mAtoms()
+    {
+    }
+    template< class TNode, std::enable_if_t<detail::is_basic_node<TNode>::value, int> = 0 >
+    explicit tape(const TNode &n);
+
+    tape_cursor root() const noexcept
+    {
+        return { mEntries.data(), mAtoms.data(), 0 };
+    }
+
+    const std::vector<tape_entry> & entries() const noexcept
+    {
+        return mEntries;
+    }
+    std::string_view atoms() const noexcept
+    {
+        return mAtoms;
+    }
+
+    void swap(tape &other) noexcept
+    {
+        mEntries.swap(other.mEntries);
+        mAtoms.swap(other.mAtoms);
+    }
+
+private:
+    tape(std::vector<tape_entry> entries, std::string atoms) noexcept
+        : mEntries(std::move(entries))
+        , mAtoms(std::move(atoms))
+    {
+    }
+
+    std::vector<tape_entry> mEntries;
+    std::string mAtoms;
+};
+
+inline void swap(tape &lhs, tape &rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+
+// event handler which records exactly one expression on a tape
+class tape_builder
+{
+public:
+    tape_builder() = default;
+
+    void begin_list()
+    {
+        add_child();
+        mFrames.push_back(mEntries.size());
+        mEntries.push_back(tape_entry::make(tape_tag::list_begin, 0, 0));
+    }
+    void end_list()
+    {
+        const auto begin = mFrames.back();
+        mFrames.pop_back();
+        const auto end = mEntries.size();
+        auto &e = mEntries[begin];
+        e = tape_entry::make(tape_tag::list_begin, end, e.extra);
+        mEntries.push_back(tape_entry::make(tape_tag::list_end, begin, 0));
+    }
+    void atom(std::string_view value, bool escaped)
+    {
+        add_child();
+        const auto offset = mAtoms.size();
+        if (escaped)
+        {
+            unescape(value, mAtoms);
+        }
+        else
+        {
+            mAtoms.append(value.data(), value.size());
+        }
+        mEntries.push_back(tape_entry::make(tape_tag::atom, offset, mAtoms.size() - offset));
+    }
+
+    // number of currently open lists
+    std::size_t depth() const noexcept
+    {
+        return mFrames.size();
+    }
+
+    tape finish()
+    {
+        if (mFrames.size() || mEntries.empty())
+        {
+            throw std::domain_error("tape_builder::finish() requires exactly one complete expression");
+        }
+        return tape(std::move(mEntries), std::move(mAtoms));
+    }
+
+private:
+    void add_child()
+    {
+        if (!mFrames.empty())
+        {
+            ++mEntries[mFrames.back()].extra;
+        }
+    }
+
+    std::vector<tape_entry> mEntries;
+    std::string mAtoms;
+    std::vector<std::size_t> mFrames;
+};
+
+
+template< class TNode, std::enable_if_t<detail::is_basic_node<TNode>::value, int> >
+inline tape::tape(const TNode &n)
+{
+    tape_builder builder;
+    walk_events(n, builder);
+    *this = builder.finish();
+}
+
+// parses exactly one expression directly onto a tape
+inline tape parse_tape(std::string_view input)
+{
+    reader r(input);
+    tape_builder builder;
+    detail::read_single(r, input, builder);
+    return builder.finish();
+}
+
+template< class TNode = node >
+inline TNode to_node(const tape_cursor &t,
+    const typename TNode::allocator_type &alloc = typename TNode::allocator_type())
+{
+    tree_builder<TNode> builder(default_atom_factory<typename TNode::string>(), alloc);
+    walk_events(t, builder);
+    return std::move(builder.values().front());
+}
+
+}
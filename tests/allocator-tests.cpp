@@ -0,0 +1,169 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/data.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+#include <memory_resource>
+
+#include "boost-unit-test.hpp"
+
+using namespace sexpr;
+
+
+namespace
+{
+// every list and string of the tree has to use the given resource
+bool uses_resource(const pmr::node &n, std::pmr::memory_resource *resource)
+{
+    if (n.get_allocator().resource() != resource)
+    {
+        return false;
+    }
+    if (n.is_string())
+    {
+        return n.get_string().get_allocator().resource() == resource;
+    }
+    for (const auto &child : n)
+    {
+        if (!uses_resource(child, resource))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// makes sure nothing is silently allocated from the default resource
+struct default_resource_guard
+{
+    std::pmr::memory_resource *previous;
+
+    default_resource_guard()
+        : previous(std::pmr::set_default_resource(std::pmr::null_memory_resource()))
+    {
+    }
+    ~default_resource_guard()
+    {
+        std::pmr::set_default_resource(previous);
+    }
+};
+
+const std::string long_atom(100, 'x');
+}
+
+
+BOOST_AUTO_TEST_SUITE(allocator_tests)
+
+
+BOOST_AUTO_TEST_CASE(std_allocator)
+{
+    node n(std::allocator<node>{});
+    BOOST_TEST(n.is_list());
+    node s(std::string("foo"), n.get_allocator());
+    BOOST_TEST(s.get_string() == "foo");
+}
+
+BOOST_AUTO_TEST_CASE(construct_in_arena)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    default_resource_guard guard;
+
+    pmr::node n(&arena);
+    n.emplace_back(std::pmr::string(long_atom, &arena));
+    n.emplace_back();
+    n.back().push_back(pmr::node(std::pmr::string(long_atom, &arena), &arena));
+    n.resize(4);
+
+    BOOST_TEST(uses_resource(n, &arena));
+}
+
+BOOST_AUTO_TEST_CASE(emplace_atoms_in_arena)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    default_resource_guard guard;
+
+    // longer than the small string buffer
+    pmr::node n(&arena);
+    n.emplace_back("a literal which doesn't fit into the string object");
+    n.emplace_back(std::string_view(long_atom));
+    n.push_back("short");
+    n.emplace_back().emplace_back("another literal which has to be allocated");
+
+    BOOST_TEST_REQUIRE(n.size() == 4u);
+    BOOST_TEST(std::string_view(n[0].get_string()) == "a literal which doesn't fit into the string object");
+    BOOST_TEST(std::string_view(n[1].get_string()) == long_atom);
+    BOOST_TEST(std::string_view(n[2].get_string()) == "short");
+    BOOST_TEST(uses_resource(n, &arena));
+}
+
+BOOST_AUTO_TEST_CASE(copy_into_arena)
+{
+    std::pmr::monotonic_buffer_resource source, target;
+    auto original = parse<pmr::node>("(a (b (c " + long_atom + ")) d)", &source);
+
+    default_resource_guard guard;
+    pmr::node copy(original, &target);
+    BOOST_TEST(uses_resource(copy, &target));
+    BOOST_TEST(uses_resource(original, &source));
+    BOOST_TEST((copy == original));
+
+    pmr::node moved(std::move(copy), &target);
+    BOOST_TEST(uses_resource(moved, &target));
+    BOOST_TEST((moved == original));
+}
+
+BOOST_AUTO_TEST_CASE(swap_across_resources)
+{
+    std::pmr::monotonic_buffer_resource a, b, expected;
+    const auto xs = parse<pmr::node>("(a (b " + long_atom + "))", &expected);
+    const auto ys = parse<pmr::node>("(c d e)", &expected);
+    pmr::node x(xs, &a);
+    pmr::node y(ys, &b);
+
+    default_resource_guard guard;
+    x.swap(y);
+    BOOST_TEST(uses_resource(x, &a));
+    BOOST_TEST(uses_resource(y, &b));
+    BOOST_TEST((x == ys));
+    BOOST_TEST((y == xs));
+
+    pmr::node s(std::pmr::string(long_atom, &b), &b);
+    swap(x, s);
+    BOOST_TEST(uses_resource(x, &a));
+    BOOST_TEST(uses_resource(s, &b));
+    BOOST_TEST(std::string_view(x.get_string()) == long_atom);
+    BOOST_TEST((s == ys));
+
+    // equal resources exchange their buffers
+    auto z = parse<pmr::node>("(f)", &a);
+    const auto buffer = z.get_list().data();
+    swap(x, z);
+    BOOST_TEST(x.get_list().data() == buffer);
+}
+
+BOOST_AUTO_TEST_CASE(parse_into_arena)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    default_resource_guard guard;
+
+    auto n = parse<pmr::node>("(config (host \"" + long_atom + "\\\"\") (port 80) ())", &arena);
+    BOOST_TEST_REQUIRE(n.size() == 4u);
+    BOOST_TEST(std::string_view(n[1][1].get_string()) == long_atom + "\"");
+    BOOST_TEST(uses_resource(n, &arena));
+}
+
+BOOST_AUTO_TEST_CASE(ordering)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    auto a = parse<pmr::node>("(a b)", &arena);
+    auto b = parse<pmr::node>("(a c)", &arena);
+    BOOST_TEST((a < b));
+    BOOST_TEST((a != b));
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,189 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/cow_vector.hpp>
+#include <sexpr-cpp/parser.hpp>
+#include <sexpr-cpp/emitter.hpp>
+
+#include <thread>
+#include <utility>
+#include <memory_resource>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+namespace
+{
+// whether both lists use the same buffer
+template< class TNode >
+bool shared(const TNode &lhs, const TNode &rhs)
+{
+    return lhs.get_list().data() == rhs.get_list().data();
+}
+}
+
+
+BOOST_AUTO_TEST_SUITE(cow_tests)
+
+
+BOOST_AUTO_TEST_CASE(copy_shares)
+{
+    const auto n = parse<cow_node>("(a (b c) (d (e f)) g)");
+    const cow_node copy = n;
+
+    BOOST_TEST(copy == n);
+    BOOST_TEST(shared(copy, n));
+    BOOST_TEST(n.get_list().use_count() == 2u);
+    BOOST_TEST(&copy[2][1] == &n[2][1]);
+}
+
+BOOST_AUTO_TEST_CASE(mutation_copies_the_path)
+{
+    const auto n = parse<cow_node>("(a (b c) (d (e f)) g)");
+    cow_node copy = n;
+
+    copy[2][1][0] = "x";
+    BOOST_TEST(to_string(n) == "(a (b c) (d (e f)) g)");
+    BOOST_TEST(to_string(copy) == "(a (b c) (d (x f)) g)");
+
+    const auto &ccopy = std::as_const(copy);
+    BOOST_TEST(!shared(ccopy, n));
+    BOOST_TEST(!shared(ccopy[2], n[2]));
+    BOOST_TEST(!shared(ccopy[2][1], n[2][1]));
+    // siblings of the path keep sharing
+    BOOST_TEST(shared(ccopy[1], n[1]));
+    BOOST_TEST(n.get_list().unique());
+}
+
+BOOST_AUTO_TEST_CASE(mutators_unshare)
+{
+    const auto n = parse<cow_node>("(a b c d)");
+
+    cow_node erased = n;
+    erased.erase(erased.cbegin() + 1);
+    BOOST_TEST(to_string(erased) == "(a c d)");
+
+    cow_node inserted = n;
+    inserted.insert(inserted.cbegin() + 2, cow_node{ "x" });
+    BOOST_TEST(to_string(inserted) == "(a b (x) c d)");
+
+    cow_node pushed = n;
+    pushed.push_back("e");
+    pushed.emplace_back("f");
+    BOOST_TEST(to_string(pushed) == "(a b c d e f)");
+
+    cow_node resized = n;
+    resized.resize(2);
+    BOOST_TEST(to_string(resized) == "(a b)");
+
+    cow_node cleared = n;
+    cleared.clear();
+    BOOST_TEST(cleared.empty());
+
+    cow_node appended = n;
+    appended.get_list().front().get_string() += "a";
+    BOOST_TEST(to_string(appended) == "(aa b c d)");
+
+    BOOST_TEST(to_string(n) == "(a b c d)");
+    BOOST_TEST(n.get_list().unique());
+}
+
+BOOST_AUTO_TEST_CASE(assignment)
+{
+    const auto n = parse<cow_node>("(a (b) c)");
+    cow_node m{ "x" };
+    m = n;
+    BOOST_TEST(shared(m, n));
+
+    m = std::move(m[1]);
+    BOOST_TEST(to_string(m) == "(b)");
+    BOOST_TEST(to_string(n) == "(a (b) c)");
+}
+
+BOOST_AUTO_TEST_CASE(deep_trees)
+{
+    cow_node n;
+    cow_node *current = &n;
+    for (int i = 0; i < 100000; ++i)
+    {
+        current->emplace_back("x");
+        current = &current->emplace_back();
+    }
+
+    auto copy = std::make_unique<cow_node>(n);
+    BOOST_TEST(shared(*copy, n));
+    current = copy.get();
+    while (current->size() > 1)
+    {
+        current = &(*current)[1];
+    }
+    current->emplace_back("y");
+    BOOST_TEST(*copy != n);
+
+    // either order tears down the deep tree without recursion
+    n = cow_node();
+    copy.reset();
+}
+
+BOOST_AUTO_TEST_CASE(snapshots_across_threads)
+{
+    std::string text = "(root";
+    for (int i = 0; i < 200; ++i)
+    {
+        text += " (item " + std::to_string(i) + " (value x))";
+    }
+    text += ')';
+    const auto n = parse<cow_node>(text);
+
+    std::vector<std::thread> workers;
+    std::vector<int> results(8);
+    for (int t = 0; t < 8; ++t)
+    {
+        workers.emplace_back([&, t]()
+        {
+            for (int round = 0; round < 50; ++round)
+            {
+                cow_node snapshot = n;
+                snapshot[1 + t][2][1] = "y";
+                results[t] += snapshot != n && snapshot[2 + t] == n[2 + t];
+            }
+        });
+    }
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+
+    for (auto r : results)
+    {
+        BOOST_TEST(r == 50);
+    }
+    BOOST_TEST(n == parse<cow_node>(text));
+    BOOST_TEST(n.get_list().unique());
+}
+
+BOOST_AUTO_TEST_CASE(memory_resources)
+{
+    std::pmr::monotonic_buffer_resource source, target;
+    const auto n = parse<pmr::cow_node>("(a (b c) d)", &source);
+
+    pmr::cow_node same(n, &source);
+    BOOST_TEST(shared(same, n));
+
+    // the copy must not reference the source resource
+    pmr::cow_node other(n, &target);
+    BOOST_TEST(!shared(other, n));
+    BOOST_TEST(other.get_allocator().resource() == &target);
+    BOOST_TEST(other[1].get_allocator().resource() == &target);
+    BOOST_TEST(other == n);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
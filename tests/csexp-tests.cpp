@@ -0,0 +1,80 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/csexp.hpp>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+namespace bdata = boost::unit_test::data;
+
+
+BOOST_AUTO_TEST_SUITE(csexp_tests)
+
+
+BOOST_AUTO_TEST_CASE(emit_simple)
+{
+    BOOST_TEST(to_csexp(node{ "foo",{ "bar" } }) == "(3:foo(3:bar))");
+    BOOST_TEST(to_csexp(node("")) == "0:");
+    BOOST_TEST(to_csexp(node()) == "()");
+    BOOST_TEST(to_csexp(node(std::string(12, 'x'))) == "12:" + std::string(12, 'x'));
+}
+
+BOOST_AUTO_TEST_CASE(parse_simple)
+{
+    using namespace std::literals;
+    BOOST_TEST(parse_csexp("(3:foo(3:bar))") == (node{ "foo",{ "bar" } }));
+    BOOST_TEST(parse_csexp("0:") == node(""));
+    BOOST_TEST(parse_csexp("(5:a(b)\"2:\\\0)"sv) == (node{ "a(b)\"", "\\\0"s }));
+}
+
+BOOST_AUTO_TEST_CASE(borrowed_atoms)
+{
+    std::string_view input = "(3:foo10:0123456789)";
+    auto n = parse_csexp<view_node>(input);
+    BOOST_TEST_REQUIRE(n.size() == 2u);
+    BOOST_TEST(n[1].get_string() == "0123456789");
+    BOOST_TEST(n[1].get_string().data() == input.data() + 9);
+}
+
+BOOST_AUTO_TEST_CASE(syntax_errors)
+{
+    BOOST_CHECK_THROW(parse_csexp(""), parse_error);
+    BOOST_CHECK_THROW(parse_csexp("(3:foo"), parse_error);
+    BOOST_CHECK_THROW(parse_csexp("3:fo"), parse_error);
+    BOOST_CHECK_THROW(parse_csexp("3foo"), parse_error);
+    BOOST_CHECK_THROW(parse_csexp("03:foo"), parse_error);
+    BOOST_CHECK_THROW(parse_csexp("(3:foo 3:bar)"), parse_error);
+    BOOST_CHECK_THROW(parse_csexp("[4:mime]3:foo"), parse_error);
+    BOOST_CHECK_THROW(parse_csexp("3:foo)"), parse_error);
+    BOOST_CHECK_THROW(parse_csexp("99999999999999999999999:x"), parse_error);
+}
+
+BOOST_AUTO_TEST_CASE(sink_callback)
+{
+    node n{ "a",{ "bc", "" } };
+    std::string collected;
+    emit_csexp(n, [&](const char *data, std::size_t size) { collected.append(data, size); });
+    BOOST_TEST(collected == "(1:a(2:bc0:))");
+}
+
+BOOST_DATA_TEST_CASE(round_trip, bdata::make(std::initializer_list<node>{
+    node(),
+    "abcd",
+    "",
+    { "first", "sec ond", "th\"ird" },
+    { { "1first", "1second" }, "second",{ { "31first" }, "3second\\" } }
+}))
+{
+    const auto encoded = to_csexp(sample);
+    BOOST_TEST(parse_csexp(encoded) == sample);
+    BOOST_TEST(to_csexp(parse_csexp(encoded)) == encoded);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,10 @@
 //#include "precompiled.hpp"
 #include <sexpr-cpp/data.hpp>
 
+#include <thread>
+
+#include <boost/mpl/list.hpp>
+
 #include "data-helpers.hpp"
 #include "boost-unit-test.hpp"
 
@@ -117,6 +121,43 @@ BOOST_AUTO_TEST_CASE(copy_ctor)
     BOOST_TEST(n0 == n1);
 }
 
+BOOST_AUTO_TEST_CASE(noexcept_move)
+{
+    static_assert(std::is_nothrow_move_constructible<node>::value, "");
+    static_assert(std::is_nothrow_move_assignable<node>::value, "");
+    static_assert(std::is_nothrow_swappable<node>::value, "");
+    static_assert(noexcept(std::declval<node &>().swap(std::declval<node &>())), "");
+    // unequal memory resources exchange copies
+    static_assert(!std::is_nothrow_swappable<pmr::node>::value, "");
+    // moving into another memory resource copies
+    static_assert(std::is_nothrow_move_constructible<pmr::node>::value, "");
+    static_assert(!std::is_nothrow_move_assignable<pmr::node>::value, "");
+    // a tag byte next to the larger alternative
+    static_assert(sizeof(node) <= sizeof(std::string) + alignof(std::string), "");
+
+    node n0{ "foo",{ "bar" } };
+    node n1(std::move(n0));
+    BOOST_TEST(n1 == (node{ "foo",{ "bar" } }));
+}
+
+BOOST_AUTO_TEST_CASE(assignment_across_alternatives)
+{
+    node n{ "foo",{ "bar" } };
+    const node s("baz");
+    n = s;
+    BOOST_TEST_REQUIRE(n.is_string());
+    BOOST_TEST(n.get_string() == "baz");
+    BOOST_TEST(n.type_info() == typeid(node::string));
+
+    n = node{ "qux" };
+    BOOST_TEST_REQUIRE(n.is_list());
+    BOOST_TEST(n.type_info() == typeid(node::list));
+    BOOST_TEST(n == (node{ "qux" }));
+
+    n = n;
+    BOOST_TEST(n == (node{ "qux" }));
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -615,4 +656,229 @@ BOOST_DATA_TEST_CASE(comparison_test,
     BOOST_TEST((val1 >= val2) == (idx1 >= idx2));
 }
 
+BOOST_AUTO_TEST_CASE(atom_comparison_is_unsigned)
+{
+    BOOST_TEST(node("\xff") > node("a"));
+    BOOST_TEST(node("ab") < node("ab\xff"));
+    BOOST_TEST(node("ab") > node(std::string("a\0", 2)));
+}
+
+// the recursive fallback for list traits with a custom ordering
+template< template<class, class...> class T >
+struct custom_list_traits
+{
+    template< typename TComparator, class TListT >
+    static int compare(const TListT &lhs, const TListT &rhs, TComparator comp)
+    {
+        return std_list_traits<T>::compare(lhs, rhs, comp);
+    }
+};
+using custom_node = sexpr::basic_node<std::string, std::vector,
+    std_string_traits<std::string>, custom_list_traits<std::vector>>;
+
+custom_node to_custom(const node &n)
+{
+    if (n.is_string())
+    {
+        return custom_node(n.get_string());
+    }
+    custom_node result;
+    for (const auto &child : n)
+    {
+        result.push_back(to_custom(child));
+    }
+    return result;
+}
+
+BOOST_DATA_TEST_CASE(iterative_matches_recursive,
+    bdata::make(generate_comparison_nodes()) * bdata::make(generate_comparison_nodes()),
+    val1, val2)
+{
+    const auto c1 = to_custom(val1);
+    const auto c2 = to_custom(val2);
+    BOOST_TEST((val1 == val2) == (c1 == c2));
+    BOOST_TEST((val1 < val2) == (c1 < c2));
+    BOOST_TEST((val1 > val2) == (c1 > c2));
+}
+
+// builds (((...))) without recursion
+struct deep_fixture
+{
+    static constexpr std::size_t depth = 200000;
+
+    static void build(node &root, const char *leaf)
+    {
+        node *current = &root;
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            current = &current->emplace_back();
+        }
+        current->emplace_back(leaf);
+    }
+
+    deep_fixture()
+    {
+        build(lhs, "a");
+        build(rhs, "a");
+        build(other, "b");
+    }
+
+    node lhs;
+    node rhs;
+    node other;
+};
+
+BOOST_FIXTURE_TEST_CASE(deep_trees, deep_fixture)
+{
+    BOOST_TEST((lhs == rhs));
+    BOOST_TEST(!(lhs != rhs));
+    BOOST_TEST(!(lhs == other));
+    BOOST_TEST((lhs < other));
+    BOOST_TEST((other > rhs));
+    BOOST_TEST((lhs <= rhs));
+}
+
+BOOST_FIXTURE_TEST_CASE(deep_copy, deep_fixture)
+{
+    node copy(lhs);
+    BOOST_TEST((copy == lhs));
+
+    copy = other;
+    BOOST_TEST((copy == other));
+    BOOST_TEST(!(copy == lhs));
+
+    other = node("x");
+    BOOST_TEST((other == node("x")));
+}
+
+BOOST_AUTO_TEST_CASE(deep_and_wide_teardown)
+{
+    node n;
+    for (int i = 0; i < 100; ++i)
+    {
+        auto &branch = n.emplace_back();
+        node *current = &branch;
+        for (int j = 0; j < 10000; ++j)
+        {
+            current->emplace_back("x");
+            current = &current->emplace_back();
+        }
+    }
+    BOOST_TEST(n.size() == 100u);
+}
+
+
+
+BOOST_AUTO_TEST_SUITE(find_key_tests)
+
+template< class TNode >
+TNode make_alist(int size)
+{
+    TNode n;
+    for (int i = 0; i < size; ++i)
+    {
+        n.push_back(TNode{ "key" + std::to_string(i), std::to_string(i) });
+    }
+    n.push_back(TNode{ "key0", "shadowed" });
+    n.push_back(TNode{ TNode{ "key1" }, "not an atom" });
+    n.push_back(TNode("key2"));
+    n.push_back(TNode());
+    return n;
+}
+
+using alist_types = boost::mpl::list<node, indexed_node>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(lookup, TNode, alist_types)
+{
+    for (int size : { 3, 100 })
+    {
+        const auto n = make_alist<TNode>(size);
+        auto p = n.find_key("key0");
+        BOOST_TEST_REQUIRE(p);
+        BOOST_TEST((*p == TNode{ "key0", "0" }));
+        BOOST_TEST((*n.find_key("key2") == TNode{ "key2", "2" }));
+        BOOST_TEST(!n.find_key("key"));
+        BOOST_TEST(!n.find_key(""));
+    }
+    BOOST_CHECK_THROW(TNode("x").find_key("x"), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(mutation_invalidates_index)
+{
+    auto n = make_alist<indexed_node>(100);
+    BOOST_TEST(std::as_const(n).find_key("key5")->at(1) == indexed_node("5"));
+
+    n.erase(n.begin());
+    BOOST_TEST((*std::as_const(n).find_key("key0") == indexed_node{ "key0", "shadowed" }));
+    n[4][0].get_string() = "renamed";
+    BOOST_TEST(!std::as_const(n).find_key("key5"));
+    BOOST_TEST(std::as_const(n).find_key("renamed"));
+    n.push_back(indexed_node{ "new", "entry" });
+    BOOST_TEST(std::as_const(n).find_key("new"));
+    n.resize(10);
+    BOOST_TEST(!std::as_const(n).find_key("new"));
+    BOOST_TEST(std::as_const(n).find_key("key9"));
+    n.clear();
+    BOOST_TEST(!std::as_const(n).find_key("key9"));
+}
+
+BOOST_AUTO_TEST_CASE(retained_list_references)
+{
+    auto n = make_alist<indexed_node>(100);
+    auto &l = n.get_list();
+    BOOST_TEST(std::as_const(n).find_key("key50"));
+
+    // the index outlives these changes, but must not report stale positions
+    l.erase(l.begin() + 60, l.end());
+    BOOST_TEST(!std::as_const(n).find_key("key70"));
+    l.front().get_list().front().get_string() = "renamed";
+    BOOST_TEST(!std::as_const(n).find_key("key0"));
+    l.clear();
+    BOOST_TEST(!std::as_const(n).find_key("key50"));
+}
+
+BOOST_AUTO_TEST_CASE(copies_and_moves)
+{
+    auto n = make_alist<indexed_node>(100);
+    BOOST_TEST(std::as_const(n).find_key("key50"));
+
+    const indexed_node copy = n;
+    BOOST_TEST((*copy.find_key("key50") == indexed_node{ "key50", "50" }));
+
+    indexed_node moved = std::move(n);
+    BOOST_TEST((*std::as_const(moved).find_key("key50") == indexed_node{ "key50", "50" }));
+
+    indexed_node other = make_alist<indexed_node>(20);
+    BOOST_TEST(std::as_const(other).find_key("key10"));
+    other.swap(moved);
+    BOOST_TEST(std::as_const(other).find_key("key50"));
+    BOOST_TEST(!std::as_const(moved).find_key("key50"));
+    other = copy;
+    BOOST_TEST(std::as_const(other).find_key("key99"));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_lookups)
+{
+    const auto n = make_alist<indexed_node>(1000);
+    std::vector<std::thread> threads;
+    std::atomic<int> found(0);
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&n, &found]()
+        {
+            for (int i = 0; i < 1000; ++i)
+            {
+                found += n.find_key("key" + std::to_string(i)) != nullptr;
+            }
+        });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    BOOST_TEST(found == 4000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,197 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/diff.hpp>
+#include <sexpr-cpp/parser.hpp>
+#include <sexpr-cpp/emitter.hpp>
+
+#include <random>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+namespace
+{
+template< class TNode >
+void check_round_trip(const TNode &a, const TNode &b)
+{
+    const auto script = diff(a, b);
+    auto patched = a;
+    patch(patched, script);
+    BOOST_TEST(patched == b);
+
+    // through the textual representation
+    const auto text = to_string(script_to_node(script));
+    patched = a;
+    patch(patched, script_from_node(parse<TNode>(text)));
+    BOOST_TEST(patched == b);
+}
+}
+
+
+BOOST_AUTO_TEST_SUITE(diff_tests)
+
+
+BOOST_AUTO_TEST_CASE(identical_trees)
+{
+    const auto a = parse<node>("(a (b c) (d (e f)) g)");
+    BOOST_TEST(diff(a, a).empty());
+    BOOST_TEST(diff(a, parse<node>("(a (b c) (d (e f)) g)")).empty());
+    BOOST_TEST(diff(node("x"), node("x")).empty());
+}
+
+BOOST_AUTO_TEST_CASE(local_edits)
+{
+    const auto a = parse<node>("(config (server (host a) (port 80)) (client (retries 3)))");
+    const auto b = parse<node>("(config (server (host a) (port 8080)) (client (retries 3)))");
+
+    const auto script = diff(a, b);
+    BOOST_TEST_REQUIRE(script.size() == 1u);
+    BOOST_TEST((script[0].type == edit_type::replace));
+    BOOST_TEST(script[0].path == (std::vector<std::size_t>{ 1, 2, 1 }));
+    BOOST_TEST(script[0].value == node("8080"));
+    BOOST_TEST(to_string(script_to_node(script)) == "((replace (1 2 1) 8080))");
+    check_round_trip(a, b);
+
+    const auto root = diff(node("x"), a);
+    BOOST_TEST_REQUIRE(root.size() == 1u);
+    BOOST_TEST(root[0].path.empty());
+    check_round_trip(node("x"), a);
+    check_round_trip(a, node("x"));
+}
+
+BOOST_AUTO_TEST_CASE(insertions_and_erasures)
+{
+    std::string text = "(";
+    for (int i = 0; i < 1000; ++i)
+    {
+        text += " (item " + std::to_string(i) + ")";
+    }
+    text += ')';
+    const auto a = parse<node>(text);
+
+    auto b = a;
+    b.erase(b.cbegin() + 500);
+    b.insert(b.cbegin() + 10, parse<node>("(new item)"));
+    b.emplace_back("tail");
+
+    const auto script = diff(a, b);
+    BOOST_TEST_REQUIRE(script.size() == 3u);
+    BOOST_TEST(to_string(script_to_node(script))
+        == "((insert (10) (new item)) (erase (501)) (insert (1000) tail))");
+    check_round_trip(a, b);
+    check_round_trip(b, a);
+    check_round_trip(a, node());
+    check_round_trip(node(), a);
+}
+
+BOOST_AUTO_TEST_CASE(random_edits)
+{
+    std::mt19937 rng(42);
+    const auto a = parse<node>(
+        "(a (b c d) (e (f g) h) (i j (k (l m) n)) o (p) (q r s t) u (v (w (x y))) z)");
+    for (int round = 0; round < 200; ++round)
+    {
+        auto b = a;
+        for (int e = 0; e < 4; ++e)
+        {
+            node *current = &b;
+            while (!current->empty() && rng() % 3 != 0)
+            {
+                auto &child = (*current)[rng() % current->size()];
+                if (!child.is_list())
+                {
+                    break;
+                }
+                current = &child;
+            }
+            const auto size = current->size();
+            switch (rng() % 3)
+            {
+            case 0:
+                current->insert(current->cbegin() + rng() % (size + 1), node{ "n", std::to_string(e) });
+                break;
+            case 1:
+                if (size > 0)
+                {
+                    current->erase(current->cbegin() + rng() % size);
+                }
+                break;
+            case 2:
+                if (size > 0)
+                {
+                    (*current)[rng() % size] = std::to_string(round);
+                }
+                break;
+            }
+        }
+        check_round_trip(a, b);
+        check_round_trip(b, a);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_caching_nodes)
+{
+    const auto a = parse<hashed_node>("(a (b c) (d (e f)) g)");
+    auto b = a;
+    b[2][1][0] = "x";
+    b.emplace_back("h");
+
+    const auto script = diff(a, b);
+    BOOST_TEST(script.size() == 2u);
+    check_round_trip(a, b);
+}
+
+BOOST_AUTO_TEST_CASE(deep_trees)
+{
+    node a;
+    node *current = &a;
+    for (int i = 0; i < 100000; ++i)
+    {
+        current->emplace_back("x");
+        current = &current->emplace_back();
+    }
+    auto b = std::make_unique<node>(a);
+    current = b.get();
+    while (current->size() > 1)
+    {
+        current = &(*current)[1];
+    }
+    current->emplace_back("y");
+
+    const auto script = diff(a, *b);
+    BOOST_TEST_REQUIRE(script.size() == 1u);
+    BOOST_TEST((script[0].type == edit_type::insert));
+    BOOST_TEST(script[0].path.size() == 100001u);
+
+    auto patched = std::make_unique<node>(a);
+    patch(*patched, script);
+    BOOST_TEST(*patched == *b);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_scripts)
+{
+    BOOST_CHECK_THROW(script_from_node(node("insert")), std::domain_error);
+    BOOST_CHECK_THROW(script_from_node(parse<node>("((move (1) x))")), std::domain_error);
+    BOOST_CHECK_THROW(script_from_node(parse<node>("((insert (1)))")), std::domain_error);
+    BOOST_CHECK_THROW(script_from_node(parse<node>("((erase (1) x))")), std::domain_error);
+    BOOST_CHECK_THROW(script_from_node(parse<node>("((erase (-1)))")), std::domain_error);
+    BOOST_CHECK_THROW(script_from_node(parse<node>("((erase (1x)))")), std::domain_error);
+    BOOST_CHECK_THROW(script_from_node(parse<node>("((erase 1))")), std::domain_error);
+
+    auto n = parse<node>("(a b)");
+    BOOST_CHECK_THROW(patch(n, script_from_node(parse<node>("((erase ()))"))), std::domain_error);
+    BOOST_CHECK_THROW(patch(n, script_from_node(parse<node>("((erase (2)))"))), std::out_of_range);
+    BOOST_CHECK_THROW(patch(n, script_from_node(parse<node>("((insert (3) x))"))), std::out_of_range);
+    BOOST_CHECK_THROW(patch(n, script_from_node(parse<node>("((replace (0 0) x))"))), std::domain_error);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
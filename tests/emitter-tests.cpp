@@ -0,0 +1,119 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/emitter.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+namespace bdata = boost::unit_test::data;
+
+
+BOOST_AUTO_TEST_SUITE(emitter_tests)
+
+
+BOOST_AUTO_TEST_CASE(compact)
+{
+    node n{ "foo",{ "bar", "baz" },{ "foobar" }, node(), "oh my" };
+    BOOST_TEST(to_string(n) == R"((foo (bar baz) (foobar) () "oh my"))");
+    BOOST_TEST(to_string(node("atom")) == "atom");
+}
+
+BOOST_AUTO_TEST_CASE(quoting)
+{
+    using namespace std::string_literals;
+    BOOST_TEST(to_string(node("")) == R"("")");
+    BOOST_TEST(to_string(node("a\"b")) == R"("a\"b")");
+    BOOST_TEST(to_string(node("a\\b")) == R"(a\b)");
+    BOOST_TEST(to_string(node("a b\\")) == R"("a b\\")");
+    BOOST_TEST(to_string(node("(")) == R"("(")");
+    BOOST_TEST(to_string(node("\0"s)) == "\0"s);
+
+    const std::string longAtom(100, 'x');
+    BOOST_TEST(!detail::needs_quoting(longAtom));
+    BOOST_TEST(detail::needs_quoting(longAtom + " "));
+    BOOST_TEST(detail::needs_quoting(std::string(64, 'x') + ")" + longAtom));
+}
+
+BOOST_AUTO_TEST_CASE(pretty)
+{
+    auto n = parse("(config (server (host a) (port 80)) (debug) ())");
+    emit_options opts;
+    opts.style = emit_style::pretty;
+
+    BOOST_TEST(to_string(n, opts) ==
+        "(config\n"
+        "  (server\n"
+        "    (host a)\n"
+        "    (port 80))\n"
+        "  (debug)\n"
+        "  ())");
+
+    opts.indent = 1;
+    BOOST_TEST(to_string(parse("(a (b))"), opts) == "(a\n (b))");
+}
+
+BOOST_AUTO_TEST_CASE(append_to_buffer)
+{
+    std::string out = "prefix ";
+    emit(node{ "a" }, out);
+    BOOST_TEST(out == "prefix (a)");
+}
+
+BOOST_AUTO_TEST_CASE(sink_callback)
+{
+    node n;
+    for (int i = 0; i < 2000; ++i)
+    {
+        n.push_back(node{ "key", std::to_string(i) });
+    }
+
+    std::string collected;
+    std::size_t calls = 0;
+    emit(n, [&](const char *data, std::size_t size)
+    {
+        ++calls;
+        collected.append(data, size);
+    });
+
+    BOOST_TEST(collected == to_string(n));
+    BOOST_TEST(calls > 1u);
+    BOOST_TEST(calls < 10u);
+}
+
+BOOST_AUTO_TEST_CASE(deep_tree)
+{
+    node n;
+    for (int i = 0; i < 10000; ++i)
+    {
+        node outer{ "x" };
+        outer.push_back(std::move(n));
+        n = std::move(outer);
+    }
+    const auto s = to_string(n);
+    BOOST_TEST(s.size() == 10000u * 4 + 2);
+}
+
+BOOST_DATA_TEST_CASE(round_trip, bdata::make(std::initializer_list<node>{
+    node(),
+    "abcd",
+    "",
+    { "first", "sec ond", "th\"ird" },
+    { { "1first", "1second" }, "second",{ { "31first" }, "3second\\" } }
+}))
+{
+    BOOST_TEST(parse(to_string(sample)) == sample);
+
+    emit_options opts;
+    opts.style = emit_style::pretty;
+    BOOST_TEST(parse(to_string(sample, opts)) == sample);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
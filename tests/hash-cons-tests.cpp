@@ -0,0 +1,117 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/hash_cons.hpp>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+BOOST_TEST_DONT_PRINT_LOG_VALUE(sexpr::consed_node)
+using namespace sexpr;
+
+
+BOOST_AUTO_TEST_SUITE(hash_cons_tests)
+
+
+BOOST_AUTO_TEST_CASE(shared_subtrees)
+{
+    hash_cons_table table;
+    auto n = parse_consed("(field (type (int 32)) (type (int 32)) (type (int 64)))", table);
+
+    BOOST_TEST_REQUIRE(n.size() == 4u);
+    BOOST_TEST(n[1].shares(n[2]));
+    BOOST_TEST(!n[1].shares(n[3]));
+    BOOST_TEST(n[1][1][0].shares(n[3][1][0]));
+    BOOST_TEST(n[1] == n[2]);
+    BOOST_TEST(n[1] != n[3]);
+
+    // field type int 32 64 (int 32) (int 64) (type (int 32)) (type (int 64)) root
+    BOOST_TEST(table.size() == 10u);
+}
+
+BOOST_AUTO_TEST_CASE(read_interface)
+{
+    hash_cons_table table;
+    auto n = parse_consed(R"((foo "a\tb" () (bar)))", table);
+
+    BOOST_TEST(n.is_list());
+    BOOST_TEST(n[0].get_string() == "foo");
+    BOOST_TEST(n[1].get_string() == "a\tb");
+    BOOST_TEST(n[2].empty());
+    BOOST_TEST(n.back().front().get_string() == "bar");
+    BOOST_TEST(n[0].size() == 1u);
+    BOOST_TEST(std::distance(n.begin(), n.end()) == 4);
+    BOOST_CHECK_THROW(n.get_string(), std::domain_error);
+    BOOST_CHECK_THROW(n[0].begin(), std::domain_error);
+    BOOST_CHECK_THROW(n.at(4), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(interning_nodes)
+{
+    node n{ "a",{ "b", "c" },{ "b", "c" },{} };
+    hash_cons_table table;
+    auto c = table.intern(n);
+    BOOST_TEST(c[1].shares(c[2]));
+    BOOST_TEST(to_node(c) == n);
+    BOOST_TEST(table.intern(n).shares(c));
+    BOOST_TEST(c[3] == consed_node());
+}
+
+BOOST_AUTO_TEST_CASE(equality_across_tables)
+{
+    hash_cons_table a;
+    hash_cons_table b;
+    auto x = parse_consed("(foo (bar baz))", a);
+    auto y = parse_consed("(foo (bar baz))", b);
+    auto z = parse_consed("(foo (bar qux))", b);
+    BOOST_TEST(!x.shares(y));
+    BOOST_TEST(x == y);
+    BOOST_TEST(x.hash() == y.hash());
+    BOOST_TEST(std::hash<consed_node>()(x) == x.hash());
+    BOOST_TEST(x != z);
+}
+
+BOOST_AUTO_TEST_CASE(manual_construction)
+{
+    hash_cons_table table;
+    auto i32 = table.make_list({ table.make_atom("int"), table.make_atom("32") });
+    auto again = table.make_list({ table.make_atom("int"), table.make_atom("32") });
+    BOOST_TEST(i32.shares(again));
+    BOOST_TEST(table.size() == 3u);
+}
+
+BOOST_AUTO_TEST_CASE(foreign_children)
+{
+    hash_cons_table table;
+    hash_cons_table other;
+    auto fromDefault = table.make_list({ consed_node() });
+    auto fromTable = table.make_list({ table.make_list({}) });
+    BOOST_TEST(fromDefault.shares(fromTable));
+    BOOST_TEST(fromDefault == fromTable);
+    BOOST_TEST(fromDefault[0].shares(fromTable[0]));
+
+    auto fromOther = table.make_list({ parse_consed("(a (b))", other), table.make_atom("c") });
+    BOOST_TEST(fromOther.shares(parse_consed("((a (b)) c)", table)));
+    BOOST_TEST(table.size() == 8u);
+}
+
+BOOST_AUTO_TEST_CASE(deep_nesting)
+{
+    constexpr std::size_t depth = 100000;
+    std::string text(depth, '(');
+    text.append(depth, ')');
+
+    hash_cons_table a;
+    hash_cons_table b;
+    auto x = parse_consed(text, a);
+    auto y = parse_consed(text, b);
+    BOOST_TEST(a.size() == depth);
+    BOOST_TEST(x == y);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
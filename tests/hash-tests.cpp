@@ -0,0 +1,132 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/hash.hpp>
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+BOOST_AUTO_TEST_SUITE(hash_tests)
+
+
+BOOST_AUTO_TEST_CASE(structural_equality)
+{
+    node a{ "foo",{ "bar", "baz" },{} };
+    node b{ "foo",{ "bar", "baz" },{} };
+    BOOST_TEST(hash_value(a) == hash_value(b));
+    BOOST_TEST(std::hash<node>()(a) == hash_value(a));
+}
+
+BOOST_AUTO_TEST_CASE(distinguishes_shapes)
+{
+    std::unordered_set<std::size_t> hashes{
+        hash_value(node("foo")),
+        hash_value(node{ "foo" }),
+        hash_value(node{ { "foo" } }),
+        hash_value(node()),
+        hash_value(node{ node() }),
+        hash_value(node{ "foo", "bar" }),
+        hash_value(node{ "bar", "foo" }),
+        hash_value(node{ { "foo" }, "bar" }),
+        hash_value(node{ "foo",{ "bar" } }),
+        hash_value(node("")),
+    };
+    BOOST_TEST(hashes.size() == 10u);
+}
+
+BOOST_AUTO_TEST_CASE(long_atoms)
+{
+    std::string text(1000, 'x');
+    auto h = hash_value(node(text));
+    text[999] = 'y';
+    BOOST_TEST(hash_value(node(text)) != h);
+    text[999] = 'x';
+    BOOST_TEST(hash_value(node(text)) == h);
+    BOOST_TEST(hash_value(node(std::string(999, 'x'))) != h);
+}
+
+BOOST_AUTO_TEST_CASE(unordered_map_keys)
+{
+    std::unordered_map<node, int> memo;
+    memo[node{ "add", "1", "2" }] = 3;
+    memo[node{ "add", "2", "2" }] = 4;
+    BOOST_TEST(memo.size() == 2u);
+    BOOST_TEST(memo.at(node{ "add", "1", "2" }) == 3);
+}
+
+BOOST_AUTO_TEST_CASE(cached_hash_matches)
+{
+    node plain{ "foo",{ "bar",{ "baz" } }, "" };
+    hashed_node cached{ "foo",{ "bar",{ "baz" } }, "" };
+    BOOST_TEST(hash_value(cached) == hash_value(plain));
+    BOOST_TEST(hash_value(cached) == hash_value(plain));
+}
+
+BOOST_AUTO_TEST_CASE(mutation_invalidates_cache)
+{
+    hashed_node n{ "foo",{ "bar" } };
+    const auto initial = hash_value(n);
+
+    n.push_back("baz");
+    BOOST_TEST(hash_value(n) == hash_value(hashed_node{ "foo",{ "bar" }, "baz" }));
+    n.pop_back();
+    BOOST_TEST(hash_value(n) == initial);
+
+    n[1][0].get_string() = "qux";
+    BOOST_TEST(hash_value(n) == hash_value(hashed_node{ "foo",{ "qux" } }));
+
+    n.resize(1);
+    BOOST_TEST(hash_value(n) == hash_value(hashed_node{ "foo" }));
+    n.erase(n.begin());
+    BOOST_TEST(hash_value(n) == hash_value(hashed_node()));
+    n.insert(n.end(), hashed_node{ "foo" });
+    BOOST_TEST(hash_value(n) == hash_value(hashed_node{ { "foo" } }));
+}
+
+BOOST_AUTO_TEST_CASE(copies_and_moves)
+{
+    hashed_node a{ "foo",{ "bar" } };
+    const auto h = hash_value(a);
+    hashed_node b = a;
+    BOOST_TEST(hash_value(b) == h);
+    hashed_node c = std::move(a);
+    BOOST_TEST(hash_value(c) == h);
+    BOOST_TEST(hash_value(a) == hash_value(hashed_node()));
+
+    hashed_node d("x");
+    hash_value(d);
+    d.swap(c);
+    BOOST_TEST(hash_value(d) == h);
+    BOOST_TEST(hash_value(c) == hash_value(hashed_node("x")));
+}
+
+BOOST_AUTO_TEST_CASE(no_overhead_without_caching)
+{
+    BOOST_TEST(sizeof(node) == sizeof(basic_node<std::string, std::vector,
+        std_string_traits<std::string>, std_list_traits<std::vector>>));
+}
+
+BOOST_AUTO_TEST_CASE(deep_nesting)
+{
+    hashed_node n;
+    hashed_node *leaf = &n;
+    for (int i = 0; i < 100000; ++i)
+    {
+        leaf = &leaf->emplace_back();
+    }
+    const auto h = hash_value(n);
+    BOOST_TEST(hash_value(n) == h);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
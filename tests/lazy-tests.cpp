@@ -0,0 +1,87 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/lazy.hpp>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+BOOST_AUTO_TEST_SUITE(lazy_tests)
+
+
+BOOST_AUTO_TEST_CASE(read_interface)
+{
+    lazy_document doc(R"x((rec (id 7) (name "a\"b") (payload (x (y z)) "(" ")")) next)x");
+    auto root = doc.root();
+    BOOST_TEST_REQUIRE(root.size() == 2u);
+    BOOST_TEST(root[1].get_string() == "next");
+
+    auto rec = root.front();
+    BOOST_TEST(rec.is_list());
+    BOOST_TEST(rec.size() == 4u);
+    BOOST_TEST(rec[0].get_string() == "rec");
+    BOOST_TEST(rec[2][1].get_string() == "a\"b");
+    BOOST_TEST(rec.back().text() == R"x((payload (x (y z)) "(" ")"))x");
+    BOOST_TEST(rec.at(1).back().get_string() == "7");
+    BOOST_TEST(std::distance(rec.begin(), rec.end()) == 4);
+    BOOST_TEST(rec.begin()->is_string());
+    BOOST_TEST(!rec.empty());
+
+    BOOST_CHECK_THROW(rec.get_string(), std::domain_error);
+    BOOST_CHECK_THROW(rec[0].begin(), std::domain_error);
+    BOOST_CHECK_THROW(rec.at(4), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(unvisited_subtrees_stay_unindexed)
+{
+    std::string input = "(rec (id 1) (blob";
+    for (int i = 0; i < 1000; ++i)
+    {
+        input += " (a (b c) \"d e\")";
+    }
+    input += "))";
+
+    lazy_document doc(input);
+    BOOST_TEST(doc.num_indexed() == 2u);
+    auto id = doc.root()[0].find_key("id");
+    BOOST_TEST_REQUIRE(id.valid());
+    BOOST_TEST(id[1].get_string() == "1");
+    BOOST_TEST(doc.num_indexed() == 7u);
+    BOOST_TEST(!doc.root()[0].find_key("nope").valid());
+    BOOST_TEST(doc.num_indexed() == 7u);
+    BOOST_TEST(doc.root()[0].find_key("blob").size() == 1001u);
+}
+
+BOOST_AUTO_TEST_CASE(materialization)
+{
+    const std::string_view input = R"((foo (bar "baz qux")) () "x\ty")";
+    lazy_document doc(input);
+    auto root = doc.root();
+    BOOST_TEST(to_node(root[0]) == (node{ "foo",{ "bar", "baz qux" } }));
+    BOOST_TEST(to_node(root[0][1]) == (node{ "bar", "baz qux" }));
+    BOOST_TEST(to_node(root[1]) == node());
+    BOOST_TEST(to_node(root[2]) == node("x\ty"));
+    BOOST_TEST(to_node(root) == (node{ { "foo",{ "bar", "baz qux" } }, {}, "x\ty" }));
+
+    lazy_document single("(a)");
+    BOOST_TEST(to_node(single.root()) == (node{ { "a" } }));
+    BOOST_TEST(to_node(single.root()[0]) == (node{ "a" }));
+}
+
+BOOST_AUTO_TEST_CASE(structural_errors)
+{
+    BOOST_CHECK_THROW(lazy_document("(a (b)"), parse_error);
+    BOOST_CHECK_THROW(lazy_document("a)"), parse_error);
+    BOOST_CHECK_THROW(lazy_document("(\"a)"), parse_error);
+    BOOST_TEST(lazy_document("").root().empty());
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
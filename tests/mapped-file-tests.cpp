@@ -0,0 +1,99 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/mapped_file.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+#include "boost-unit-test.hpp"
+
+using namespace sexpr;
+
+
+namespace
+{
+struct temp_file
+{
+    std::string path;
+
+    temp_file(std::string name, std::string_view content)
+        : path(std::move(name))
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+    ~temp_file()
+    {
+        std::remove(path.c_str());
+    }
+};
+}
+
+
+BOOST_AUTO_TEST_SUITE(mapped_file_tests)
+
+
+BOOST_AUTO_TEST_CASE(map_file)
+{
+    temp_file tmp("sexpr-cpp-mapped-file.sexpr", "(a b c)");
+    mapped_file f(tmp.path);
+    BOOST_TEST(f.size() == 7u);
+    BOOST_TEST(f.view() == "(a b c)");
+
+    mapped_file g(std::move(f));
+    BOOST_TEST(!f.data());
+    BOOST_TEST(g.view() == "(a b c)");
+}
+
+BOOST_AUTO_TEST_CASE(map_empty_file)
+{
+    temp_file tmp("sexpr-cpp-mapped-file-empty.sexpr", "");
+    mapped_file f(tmp.path);
+    BOOST_TEST(f.size() == 0u);
+    BOOST_TEST(f.view().empty());
+}
+
+BOOST_AUTO_TEST_CASE(map_missing_file)
+{
+    BOOST_CHECK_THROW(mapped_file("sexpr-cpp-does-not-exist.sexpr"), std::system_error);
+}
+
+BOOST_AUTO_TEST_CASE(borrowed_atoms)
+{
+    temp_file tmp("sexpr-cpp-mapped-document.sexpr",
+        "(config (host \"example.org\") (motd \"say \\\"hi\\\"\"))");
+    mapped_document doc(tmp.path);
+
+    const auto &root = doc.root();
+    BOOST_TEST_REQUIRE(root.size() == 3u);
+    BOOST_TEST(root[0].get_string() == "config");
+    BOOST_TEST(root[1][1].get_string() == "example.org");
+    BOOST_TEST(root[2][1].get_string() == "say \"hi\"");
+
+    // plain atoms point into the mapping
+    const auto mapping = doc.file().view();
+    const auto host = root[1][1].get_string();
+    BOOST_TEST((host.data() >= mapping.data() && host.data() < mapping.data() + mapping.size()));
+
+    mapped_document moved(std::move(doc));
+    BOOST_TEST(moved.root()[1][1].get_string().data() == host.data());
+    BOOST_TEST(moved.root()[2][1].get_string() == "say \"hi\"");
+}
+
+BOOST_AUTO_TEST_CASE(view_node_parse)
+{
+    std::string_view input = "(a (b))";
+    auto n = parse<view_node>(input);
+    BOOST_TEST(n[1][0].get_string().data() == input.data() + 4);
+    BOOST_CHECK_THROW(parse<view_node>(R"("a\"b")"), std::domain_error);
+
+    view_node literal("lit");
+    BOOST_TEST(literal.get_string() == "lit");
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/memory.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+#include <optional>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+BOOST_AUTO_TEST_SUITE(memory_tests)
+
+
+BOOST_AUTO_TEST_CASE(tree_stats)
+{
+    const std::string long_atom(100, 'x');
+    node n{ "a",{ "b", long_atom },{} };
+    n.get_list().reserve(8);
+
+    const auto stats = memory_stats(n);
+    BOOST_TEST(stats.nodes == 6u);
+    BOOST_TEST(stats.lists == 3u);
+    BOOST_TEST(stats.atoms == 3u);
+    BOOST_TEST(stats.max_depth == 2u);
+    BOOST_TEST(stats.atom_bytes == 102u);
+    BOOST_TEST(stats.atom_heap_bytes >= 101u);
+    BOOST_TEST(stats.list_slack == 5u);
+    BOOST_TEST(stats.list_slack_bytes == 5 * sizeof(node));
+    BOOST_TEST(stats.list_heap_bytes == 10 * sizeof(node));
+    // the root and (b ...) buffers plus the long atom; () has no storage
+    BOOST_TEST(stats.heap_blocks == 3u);
+    BOOST_TEST(stats.heap_bytes() == stats.list_heap_bytes + stats.atom_heap_bytes);
+
+    const auto atom = memory_stats(node("foo"));
+    BOOST_TEST(atom.nodes == 1u);
+    BOOST_TEST(atom.heap_blocks == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(slack_after_mutation)
+{
+    node n;
+    for (int i = 0; i < 100; ++i)
+    {
+        n.emplace_back("x");
+    }
+    n.resize(10);
+    BOOST_TEST(memory_stats(n).list_slack >= 90u);
+    BOOST_TEST(memory_stats(node(n)).list_slack == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(view_atoms_own_no_memory)
+{
+    const auto stats = memory_stats(view_node{ std::string_view("borrowed atom which is quite long") });
+    BOOST_TEST(stats.atom_bytes == 33u);
+    BOOST_TEST(stats.atom_heap_bytes == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(counting_parse)
+{
+    counting_resource res;
+    const std::string text = "(a (b " + std::string(100, 'c') + ") () d)";
+    {
+        pmr::node n(&res);
+        const auto parsed = count_allocations(res, [&]() { n = parse<pmr::node>(text, &res); });
+        BOOST_TEST(parsed.allocations > 0u);
+        BOOST_TEST(parsed.deallocations < parsed.allocations);
+        BOOST_TEST(parsed.live_bytes == parsed.bytes_allocated - parsed.bytes_deallocated);
+        BOOST_TEST(parsed.peak_bytes >= parsed.live_bytes);
+
+        // the live blocks are exactly the estimated heap blocks
+        const auto stats = memory_stats(n);
+        BOOST_TEST(parsed.allocations - parsed.deallocations == stats.heap_blocks);
+        BOOST_TEST(parsed.live_bytes == stats.heap_bytes());
+
+        std::optional<pmr::node> copy;
+        const auto copied = count_allocations(res, [&]() { copy.emplace(n, &res); });
+        BOOST_TEST(copied.allocations == stats.heap_blocks);
+        BOOST_TEST(copied.deallocations == 0u);
+        BOOST_TEST(copied.peak_bytes == parsed.live_bytes + stats.heap_bytes());
+    }
+    BOOST_TEST(res.stats().live_bytes == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,104 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/parallel_parser.hpp>
+
+#include <cctype>
+#include <string>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+namespace
+{
+std::string make_batch(int count)
+{
+    std::string input;
+    for (int i = 0; i < count; ++i)
+    {
+        const auto n = std::to_string(i);
+        input += "(record " + n + R"( (name "a (quoted) \"value\"") (tags x y z)))";
+        input += (i % 7) ? "\n" : " loose-atom-" + n + "\n";
+    }
+    return input;
+}
+}
+
+
+BOOST_AUTO_TEST_SUITE(parallel_parser_tests)
+
+
+BOOST_AUTO_TEST_CASE(parse_all_sequence)
+{
+    auto values = parse_all(R"((foo) bar "baz qux" ())");
+    BOOST_TEST_REQUIRE(values.size() == 4u);
+    BOOST_TEST(values[0] == node{ "foo" });
+    BOOST_TEST(values[1] == node("bar"));
+    BOOST_TEST(values[2] == node("baz qux"));
+    BOOST_TEST(values[3] == node());
+    BOOST_TEST(parse_all("  ").empty());
+}
+
+BOOST_AUTO_TEST_CASE(split_top_level)
+{
+    const auto input = make_batch(20000);
+    const auto bounds = detail::split_top_level(input, 16);
+    BOOST_TEST_REQUIRE(bounds.size() > 8u);
+    BOOST_TEST(bounds.front() == 0u);
+    BOOST_TEST(bounds.back() == input.size());
+    for (std::size_t i = 1; i + 1 < bounds.size(); ++i)
+    {
+        BOOST_TEST(input[bounds[i] - 1] == ')');
+        BOOST_TEST(std::isspace(static_cast<unsigned char>(input[bounds[i]])));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(matches_sequential_parse)
+{
+    const auto input = make_batch(20000);
+    const auto expected = parse_all(input);
+    for (unsigned threads : { 1u, 2u, 3u, 8u, 0u })
+    {
+        BOOST_TEST_CONTEXT("threads " << threads)
+        {
+            BOOST_TEST((parse_all_parallel(input, threads) == expected));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(small_input)
+{
+    BOOST_TEST(parse_all_parallel("").empty());
+    BOOST_TEST((parse_all_parallel("(a) b", 4) == parse_all("(a) b")));
+}
+
+BOOST_AUTO_TEST_CASE(error_offsets)
+{
+    auto input = make_batch(20000);
+    const auto at = input.size() * 3 / 4;
+    input.insert(input.find('\n', at) + 1, "(oops");
+    input.insert(input.find('\n', at / 2) + 1, ")");
+
+    std::size_t expected = 0;
+    try
+    {
+        parse_all(input);
+        BOOST_FAIL("parse_all() accepted malformed input");
+    }
+    catch (const parse_error &e)
+    {
+        expected = e.offset();
+    }
+    BOOST_CHECK_EXCEPTION(parse_all_parallel(input, 4), parse_error,
+        [=](const parse_error &e) { return e.offset() == expected; });
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/parser.hpp>
+
+#include <cctype>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+BOOST_AUTO_TEST_SUITE(parser_tests)
+
+
+BOOST_AUTO_TEST_CASE(single_atom)
+{
+    BOOST_TEST(parse("  foo\n") == node("foo"));
+    BOOST_TEST(parse(R"("foo bar")") == node("foo bar"));
+    BOOST_TEST(parse(R"("a\"b")") == node("a\"b"));
+}
+
+BOOST_AUTO_TEST_CASE(empty_list)
+{
+    auto n = parse("()");
+    BOOST_TEST_REQUIRE(n.is_list());
+    BOOST_TEST(n.empty());
+}
+
+BOOST_AUTO_TEST_CASE(nested_lists)
+{
+    auto n = parse(R"((foo (bar baz) ("foobar") "oh my"))");
+    node expected{ "foo",{ "bar", "baz" },{ "foobar" }, "oh my" };
+    BOOST_TEST(n == expected);
+}
+
+BOOST_AUTO_TEST_CASE(exact_list_allocation)
+{
+    std::string input = "(";
+    for (int i = 0; i < 1000; ++i)
+    {
+        input += "(a b c) x ";
+    }
+    input += ")";
+
+    auto n = parse(input);
+    BOOST_TEST_REQUIRE(n.size() == 2000u);
+    BOOST_TEST(n.get_list().capacity() == n.size());
+    BOOST_TEST(n[0].get_list().capacity() == 3u);
+}
+
+BOOST_AUTO_TEST_CASE(custom_atom_factory)
+{
+    auto upper = [](std::string_view value, bool)
+    {
+        std::string s(value);
+        for (auto &c : s)
+        {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        return s;
+    };
+    BOOST_TEST(parse<node>("(a (b))", upper) == (node{ "A",{ "B" } }));
+}
+
+BOOST_AUTO_TEST_CASE(syntax_errors)
+{
+    BOOST_CHECK_THROW(parse(""), parse_error);
+    BOOST_CHECK_THROW(parse("   "), parse_error);
+    BOOST_CHECK_THROW(parse("(a"), parse_error);
+    BOOST_CHECK_THROW(parse("a)"), parse_error);
+    BOOST_CHECK_THROW(parse("(a) b"), parse_error);
+    BOOST_CHECK_THROW(parse("\"abc"), parse_error);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
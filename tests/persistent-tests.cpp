@@ -0,0 +1,175 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/persistent.hpp>
+#include <sexpr-cpp/emitter.hpp>
+
+#include <thread>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+BOOST_TEST_DONT_PRINT_LOG_VALUE(sexpr::persistent_node)
+using namespace sexpr;
+
+
+BOOST_AUTO_TEST_SUITE(persistent_tests)
+
+
+BOOST_AUTO_TEST_CASE(read_interface)
+{
+    auto n = parse_persistent(R"((foo "a\tb" () (bar)))");
+
+    BOOST_TEST(n.is_list());
+    BOOST_TEST(n[0].get_string() == "foo");
+    BOOST_TEST(n[1].get_string() == "a\tb");
+    BOOST_TEST(n[2].empty());
+    BOOST_TEST(n.back().front().get_string() == "bar");
+    BOOST_TEST(n[0].size() == 1u);
+    BOOST_TEST(std::distance(n.begin(), n.end()) == 4);
+    BOOST_TEST(n.find_key("bar") == &n[3]);
+    BOOST_TEST(!n.find_key("foo"));
+    BOOST_CHECK_THROW(n.get_string(), std::domain_error);
+    BOOST_CHECK_THROW(n[0].begin(), std::domain_error);
+    BOOST_CHECK_THROW(n.at(4), std::out_of_range);
+
+    const persistent_node built{ "foo", "a\tb", {}, { "bar" } };
+    BOOST_TEST(built == n);
+    BOOST_TEST(to_string(built) == "(foo \"a\tb\" () (bar))");
+}
+
+BOOST_AUTO_TEST_CASE(node_conversion)
+{
+    node n{ "a",{ "b", "c" },{},{ { "d" } } };
+    const auto p = make_persistent(n);
+    BOOST_TEST(p.size() == 4u);
+    BOOST_TEST(p[3][0][0].get_string() == "d");
+    BOOST_TEST(to_node(p) == n);
+    BOOST_TEST(to_node(persistent_node("atom")) == node("atom"));
+}
+
+BOOST_AUTO_TEST_CASE(set_shares_untouched_subtrees)
+{
+    const auto v1 = parse_persistent("(config (server (host a) (port 80)) (client (retries 3)))");
+    const auto v2 = v1.set_in({ 1, 2, 1 }, "8080");
+
+    BOOST_TEST(to_string(v1) == "(config (server (host a) (port 80)) (client (retries 3)))");
+    BOOST_TEST(to_string(v2) == "(config (server (host a) (port 8080)) (client (retries 3)))");
+    BOOST_TEST(v1 != v2);
+
+    BOOST_TEST(v2[0].shares(v1[0]));
+    BOOST_TEST(v2[2].shares(v1[2]));
+    BOOST_TEST(v2[1][1].shares(v1[1][1]));
+    BOOST_TEST(!v2[1].shares(v1[1]));
+    BOOST_TEST(!v2[1][2].shares(v1[1][2]));
+
+    BOOST_TEST(v1.set_in({}, "x") == persistent_node("x"));
+    BOOST_CHECK_THROW(v1.set_in({ 0, 0 }, "x"), std::domain_error);
+    BOOST_CHECK_THROW(v1.set_in({ 3 }, "x"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(wide_lists)
+{
+    // spans three trie levels
+    const std::size_t size = 40000;
+    persistent_node pushed;
+    std::vector<persistent_node> elements;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        pushed = pushed.push_back(std::to_string(i));
+        elements.emplace_back(std::to_string(i));
+    }
+    const persistent_node built(elements.begin(), elements.end());
+    BOOST_TEST_REQUIRE(pushed.size() == size);
+    BOOST_TEST(pushed == built);
+
+    std::size_t mismatches = 0;
+    std::size_t i = 0;
+    for (const auto &child : built)
+    {
+        mismatches += child.get_string() != std::to_string(i++);
+    }
+    BOOST_TEST(i == size);
+    BOOST_TEST(mismatches == 0u);
+
+    const auto changed = built.set(12345, "x");
+    BOOST_TEST(changed[12345].get_string() == "x");
+    BOOST_TEST(built[12345].get_string() == "12345");
+    BOOST_TEST(changed[12344].shares(built[12344]));
+    BOOST_TEST(changed != built);
+    BOOST_TEST(changed.set(12345, "12345") == built);
+}
+
+BOOST_AUTO_TEST_CASE(version_history)
+{
+    auto current = parse_persistent("(counters (a 0) (b 0) (c 0))");
+    std::vector<persistent_node> history{ current };
+    for (int i = 1; i <= 100; ++i)
+    {
+        current = current.set_in({ static_cast<std::size_t>(1 + i % 3), 1 }, std::to_string(i));
+        history.push_back(current);
+    }
+
+    BOOST_TEST(to_string(history[0]) == "(counters (a 0) (b 0) (c 0))");
+    BOOST_TEST(to_string(history[4]) == "(counters (a 3) (b 4) (c 2))");
+    BOOST_TEST(to_string(history.back()) == "(counters (a 99) (b 100) (c 98))");
+    BOOST_TEST(history[1][1].shares(history[0][1]));
+}
+
+BOOST_AUTO_TEST_CASE(deep_trees)
+{
+    node n;
+    node *current = &n;
+    for (int i = 0; i < 100000; ++i)
+    {
+        current->emplace_back("x");
+        current = &current->emplace_back();
+    }
+
+    auto p = std::make_unique<persistent_node>(make_persistent(n));
+    std::vector<std::size_t> path(99999, 1);
+    path.push_back(0);
+    const auto changed = p->set_in(path, "y");
+    BOOST_TEST(changed != *p);
+    BOOST_TEST(to_node(*p) == n);
+
+    p.reset();
+}
+
+BOOST_AUTO_TEST_CASE(versions_across_threads)
+{
+    const auto base = parse_persistent("(root (a 0) (b 0) (c 0) (d 0))");
+
+    std::vector<std::thread> workers;
+    std::vector<persistent_node> results(4);
+    for (std::size_t t = 0; t < 4; ++t)
+    {
+        workers.emplace_back([&, t]()
+        {
+            auto v = base;
+            for (int i = 1; i <= 1000; ++i)
+            {
+                v = v.set_in({ 1 + t, 1 }, std::to_string(i));
+            }
+            results[t] = v;
+        });
+    }
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+
+    BOOST_TEST(to_string(base) == "(root (a 0) (b 0) (c 0) (d 0))");
+    for (std::size_t t = 0; t < 4; ++t)
+    {
+        BOOST_TEST(results[t][1 + t][1].get_string() == "1000");
+        BOOST_TEST(results[t][1 + (t + 1) % 4].shares(base[1 + (t + 1) % 4]));
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
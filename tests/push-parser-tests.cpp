@@ -0,0 +1,151 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/push_parser.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+#include <vector>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+namespace
+{
+std::vector<node> parse_chunked(std::string_view input, std::size_t chunkSize)
+{
+    std::vector<node> values;
+    auto p = make_node_parser([&values](node &&value)
+    {
+        values.push_back(std::move(value));
+    });
+    for (std::size_t i = 0; i < input.size(); i += chunkSize)
+    {
+        p.feed(input.substr(i, chunkSize));
+    }
+    p.finish();
+    return values;
+}
+
+const std::string_view sample = R"((foo (bar "baz qux") "a\"b\\c" ()) top-level "x\ty"
+    (a-rather-long-atom-which-spans-many-chunks "and a quoted one which does, too")
+    ("\\" "\"" "" last))";
+}
+
+
+BOOST_AUTO_TEST_SUITE(push_parser_tests)
+
+
+BOOST_AUTO_TEST_CASE(every_chunk_size)
+{
+    const std::vector<node> expected{
+        { "foo",{ "bar", "baz qux" }, "a\"b\\c",{} },
+        node("top-level"),
+        node("x\ty"),
+        { "a-rather-long-atom-which-spans-many-chunks", "and a quoted one which does, too" },
+        { "\\", "\"", "", "last" },
+    };
+    for (std::size_t chunkSize = 1; chunkSize <= sample.size(); ++chunkSize)
+    {
+        BOOST_TEST_CONTEXT("chunk size " << chunkSize)
+        {
+            auto values = parse_chunked(sample, chunkSize);
+            BOOST_TEST_REQUIRE(values.size() == expected.size());
+            for (std::size_t i = 0; i < values.size(); ++i)
+            {
+                BOOST_TEST(values[i] == expected[i]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bare_atoms_after_escapes)
+{
+    // backslashes within bare atoms are kept verbatim
+    const std::string_view input = R"("x\"y" a\nb c\)";
+    const std::vector<node> expected{ node("x\"y"), node(R"(a\nb)"), node(R"(c\)") };
+    BOOST_TEST_REQUIRE(parse_all(input).size() == expected.size());
+    for (std::size_t chunkSize = 1; chunkSize <= input.size(); ++chunkSize)
+    {
+        BOOST_TEST_CONTEXT("chunk size " << chunkSize)
+        {
+            auto values = parse_chunked(input, chunkSize);
+            BOOST_TEST_REQUIRE(values.size() == expected.size());
+            for (std::size_t i = 0; i < values.size(); ++i)
+            {
+                BOOST_TEST(values[i] == expected[i]);
+                BOOST_TEST(values[i] == parse_all(input)[i]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(long_input)
+{
+    std::string input;
+    for (int i = 0; i < 200; ++i)
+    {
+        input += R"((entry "value \"with\" escapes" (nested list)))";
+    }
+    auto values = parse_chunked(input, 61);
+    BOOST_TEST_REQUIRE(values.size() == 200u);
+    BOOST_TEST(values.back() == (node{ "entry", "value \"with\" escapes",{ "nested", "list" } }));
+}
+
+BOOST_AUTO_TEST_CASE(values_are_delivered_early)
+{
+    std::vector<node> values;
+    auto p = make_node_parser([&values](node &&value)
+    {
+        values.push_back(std::move(value));
+    });
+
+    p.feed("(foo) (ba");
+    BOOST_TEST(values.size() == 1u);
+    BOOST_TEST(p.depth() == 1u);
+    p.feed("r) baz");
+    BOOST_TEST(values.size() == 2u);
+    BOOST_TEST(p.depth() == 0u);
+    // the atom might continue in the next chunk
+    p.feed("");
+    BOOST_TEST(values.size() == 2u);
+    p.finish();
+    BOOST_TEST_REQUIRE(values.size() == 3u);
+    BOOST_TEST(values[2] == node("baz"));
+    BOOST_TEST(p.offset() == 15u);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    auto discard = [](node &&) {};
+    {
+        auto p = make_node_parser(discard);
+        p.feed("(foo) ");
+        BOOST_CHECK_EXCEPTION(p.feed("bar)"), parse_error,
+            [](const parse_error &e) { return e.offset() == 9; });
+    }
+    {
+        auto p = make_node_parser(discard);
+        p.feed("(foo");
+        BOOST_CHECK_THROW(p.finish(), parse_error);
+    }
+    {
+        auto p = make_node_parser(discard);
+        p.feed("\"foo");
+        BOOST_CHECK_THROW(p.finish(), parse_error);
+    }
+    {
+        auto p = make_node_parser(discard);
+        p.feed("\"foo\\");
+        BOOST_CHECK_THROW(p.finish(), parse_error);
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
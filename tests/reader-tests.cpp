@@ -0,0 +1,176 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/reader.hpp>
+
+#include <vector>
+
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(sexpr::event_type)
+using namespace sexpr;
+
+
+BOOST_AUTO_TEST_SUITE(reader_tests)
+
+
+BOOST_AUTO_TEST_CASE(empty_input)
+{
+    reader r("  \t\n ");
+    BOOST_TEST(r.next().type == event_type::end_of_input);
+    BOOST_TEST(r.next().type == event_type::end_of_input);
+}
+
+BOOST_AUTO_TEST_CASE(simple_list)
+{
+    std::string_view input = "(foo (bar) baz)";
+    reader r(input);
+
+    auto e = r.next();
+    BOOST_TEST_REQUIRE(e.type == event_type::list_begin);
+    BOOST_TEST(e.value.data() == input.data());
+    BOOST_TEST(r.depth() == 1u);
+
+    e = r.next();
+    BOOST_TEST_REQUIRE(e.type == event_type::atom);
+    BOOST_TEST(e.value == "foo");
+    BOOST_TEST(e.value.data() == input.data() + 1);
+    BOOST_TEST(!e.escaped);
+
+    BOOST_TEST(r.next().type == event_type::list_begin);
+    BOOST_TEST(r.next().value == "bar");
+    BOOST_TEST(r.next().type == event_type::list_end);
+    BOOST_TEST(r.next().value == "baz");
+
+    e = r.next();
+    BOOST_TEST_REQUIRE(e.type == event_type::list_end);
+    BOOST_TEST(e.value.data() == input.data() + input.size() - 1);
+    BOOST_TEST(r.depth() == 0u);
+
+    BOOST_TEST(r.next().type == event_type::end_of_input);
+}
+
+BOOST_AUTO_TEST_CASE(quoted_atoms)
+{
+    reader r(R"(("with space" "" "esc\"aped" x"y"))");
+
+    BOOST_TEST(r.next().type == event_type::list_begin);
+
+    auto e = r.next();
+    BOOST_TEST(e.value == "with space");
+    BOOST_TEST(!e.escaped);
+
+    e = r.next();
+    BOOST_TEST_REQUIRE(e.type == event_type::atom);
+    BOOST_TEST(e.value.empty());
+
+    e = r.next();
+    BOOST_TEST(e.value == R"(esc\"aped)");
+    BOOST_TEST(e.escaped);
+    BOOST_TEST(unescape(e.value) == "esc\"aped");
+
+    BOOST_TEST(r.next().value == "x");
+    BOOST_TEST(r.next().value == "y");
+    BOOST_TEST(r.next().type == event_type::list_end);
+}
+
+BOOST_AUTO_TEST_CASE(unescape_sequences)
+{
+    using namespace std::string_literals;
+    BOOST_TEST(unescape(R"(a\nb\tc\rd\0e\\f\(g)") == "a\nb\tc\rd\0e\\f(g"s);
+    BOOST_TEST(unescape("plain") == "plain");
+}
+
+BOOST_AUTO_TEST_CASE(multiple_top_level_values)
+{
+    reader r("a (b) c");
+    BOOST_TEST(r.next().value == "a");
+    BOOST_TEST(r.next().type == event_type::list_begin);
+    BOOST_TEST(r.next().value == "b");
+    BOOST_TEST(r.next().type == event_type::list_end);
+    BOOST_TEST(r.next().value == "c");
+    BOOST_TEST(r.next().type == event_type::end_of_input);
+}
+
+BOOST_AUTO_TEST_CASE(skip_list)
+{
+    std::string_view input = R"((rec (skip (me ")(" please)) keep))";
+    reader r(input);
+
+    BOOST_TEST(r.next().type == event_type::list_begin);
+    BOOST_TEST(r.next().value == "rec");
+    BOOST_TEST(r.next().type == event_type::list_begin);
+
+    auto e = r.skip();
+    BOOST_TEST(e.type == event_type::list_end);
+    BOOST_TEST(e.value.data() == input.data() + input.find(" keep") - 1);
+    BOOST_TEST(r.depth() == 1u);
+
+    BOOST_TEST(r.next().value == "keep");
+    BOOST_TEST(r.next().type == event_type::list_end);
+    BOOST_TEST(r.next().type == event_type::end_of_input);
+
+    reader top("abc");
+    BOOST_CHECK_THROW(top.skip(), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(syntax_errors)
+{
+    reader unbalanced("a)");
+    BOOST_TEST(unbalanced.next().value == "a");
+    BOOST_CHECK_THROW(unbalanced.next(), parse_error);
+
+    reader unterminated(R"(("abc\")");
+    BOOST_TEST(unterminated.next().type == event_type::list_begin);
+    BOOST_CHECK_THROW(unterminated.next(), parse_error);
+
+    reader open("(a (b)");
+    for (int i = 0; i < 5; ++i)
+    {
+        open.next();
+    }
+    try
+    {
+        open.next();
+        BOOST_FAIL("expected a parse_error");
+    }
+    catch (const parse_error &e)
+    {
+        BOOST_TEST(e.offset() == 6u);
+    }
+}
+
+
+struct event_recorder
+{
+    std::vector<std::string> log;
+
+    void begin_list()
+    {
+        log.push_back("(");
+    }
+    void end_list()
+    {
+        log.push_back(")");
+    }
+    void atom(std::string_view value, bool escaped)
+    {
+        log.push_back(escaped ? unescape(value) : std::string(value));
+    }
+};
+
+BOOST_AUTO_TEST_CASE(push_interface)
+{
+    event_recorder rec;
+    read_events(R"((a "b\"" (c)) d)", rec);
+
+    const std::vector<std::string> expected = { "(", "a", "b\"", "(", "c", ")", ")", "d" };
+    BOOST_CHECK_EQUAL_COLLECTIONS(rec.log.begin(), rec.log.end(),
+        expected.begin(), expected.end());
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,142 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/scanner.hpp>
+#include <sexpr-cpp/reader.hpp>
+
+#include <random>
+#include <string>
+
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(sexpr::event_type)
+using namespace sexpr;
+
+
+namespace
+{
+std::string random_block(std::mt19937 &rng)
+{
+    static constexpr char alphabet[] = "()\"\\ \t\n\r\v\fab\x80\xff";
+    std::uniform_int_distribution<std::size_t> pick(0, sizeof(alphabet) - 2);
+    std::string block(64, '\0');
+    for (auto &c : block)
+    {
+        c = alphabet[pick(rng)];
+    }
+    return block;
+}
+
+bool operator==(const block_masks &lhs, const block_masks &rhs)
+{
+    return lhs.open == rhs.open && lhs.close == rhs.close && lhs.quote == rhs.quote
+        && lhs.escape == rhs.escape && lhs.space == rhs.space;
+}
+}
+
+
+BOOST_AUTO_TEST_SUITE(scanner_tests)
+
+
+BOOST_AUTO_TEST_CASE(scalar_kernel)
+{
+    std::string block = "( )\"\\a";
+    block.resize(64, 'x');
+    block[63] = '\n';
+
+    block_masks m;
+    detail::classify_scalar(block.data(), m);
+    BOOST_TEST(m.open == 0x1u);
+    BOOST_TEST(m.close == 0x4u);
+    BOOST_TEST(m.quote == 0x8u);
+    BOOST_TEST(m.escape == 0x10u);
+    BOOST_TEST(m.space == (0x2u | std::uint64_t{ 1 } << 63));
+}
+
+BOOST_AUTO_TEST_CASE(simd_kernels_match_scalar)
+{
+    std::mt19937 rng(42);
+    for (int i = 0; i < 1000; ++i)
+    {
+        const auto block = random_block(rng);
+        block_masks expected, actual;
+        detail::classify_scalar(block.data(), expected);
+
+#if defined(SEXPR_CPP_HAS_SSE2)
+        detail::classify_sse2(block.data(), actual);
+        BOOST_TEST_REQUIRE(bool(actual == expected));
+#endif
+#if defined(SEXPR_CPP_HAS_AVX2)
+        if (detail::cpu_has_avx2())
+        {
+            detail::classify_avx2(block.data(), actual);
+            BOOST_TEST_REQUIRE(bool(actual == expected));
+        }
+#endif
+        detail::classifier()(block.data(), actual);
+        BOOST_TEST_REQUIRE(bool(actual == expected));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_boundaries)
+{
+    const std::string atom(150, 'a');
+    const std::string input = std::string(70, ' ') + atom + " \"" + std::string(60, 'q')
+        + "\\\"" + std::string(10, 'q') + "\"";
+    const char *first = input.data();
+    const char *last = first + input.size();
+
+    block_scanner scan(first, last);
+    auto pos = scan.skip_space(first);
+    BOOST_TEST(pos - first == 70);
+    pos = scan.find_atom_end(pos);
+    BOOST_TEST(pos - first == 220);
+    pos = scan.skip_space(pos);
+    BOOST_TEST_REQUIRE(*pos == '"');
+
+    bool escaped = false;
+    auto end = scan.find_quote_end(pos + 1, escaped);
+    BOOST_TEST(escaped);
+    BOOST_TEST(end == last - 1);
+
+    BOOST_TEST(scan.find_atom_end(first + 100) == first + 220);
+    BOOST_TEST(scan.skip_space(last - 1) == last - 1);
+}
+
+BOOST_AUTO_TEST_CASE(unterminated_quote_at_end)
+{
+    const std::string input = "\"abc\\";
+    block_scanner scan(input.data(), input.data() + input.size());
+    bool escaped = false;
+    BOOST_TEST(scan.find_quote_end(input.data() + 1, escaped) == input.data() + input.size());
+}
+
+BOOST_AUTO_TEST_CASE(reader_on_large_input)
+{
+    std::string input = "(";
+    for (int i = 0; i < 500; ++i)
+    {
+        input += "(key" + std::to_string(i) + " \"val ( ) \\\" " + std::to_string(i) + "\")\n";
+    }
+    input += ")";
+
+    reader r(input);
+    BOOST_TEST(r.next().type == event_type::list_begin);
+    for (int i = 0; i < 500; ++i)
+    {
+        BOOST_TEST_REQUIRE(r.next().type == event_type::list_begin);
+        BOOST_TEST_REQUIRE(r.next().value == "key" + std::to_string(i));
+        auto e = r.next();
+        BOOST_TEST_REQUIRE(e.escaped);
+        BOOST_TEST_REQUIRE(unescape(e.value) == "val ( ) \" " + std::to_string(i));
+        BOOST_TEST_REQUIRE(r.next().type == event_type::list_end);
+    }
+    BOOST_TEST(r.next().type == event_type::list_end);
+    BOOST_TEST(r.next().type == event_type::end_of_input);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/selector.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+#include <vector>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+namespace
+{
+const std::string_view config = R"((config
+    (server (name alpha) (listen (port 80) (host "a.example")) (port 8080))
+    (server (name beta) (tls (port 443)) ((port 1)))
+    (client (listen (port 9)))
+    port
+    (server))
+)";
+}
+
+
+BOOST_AUTO_TEST_SUITE(selector_tests)
+
+
+BOOST_AUTO_TEST_CASE(node_matches)
+{
+    const auto root = parse(config);
+    selector s("(config server * port)");
+    BOOST_TEST(s.size() == 4u);
+
+    auto matches = s.select(root);
+    BOOST_TEST_REQUIRE(matches.size() == 2u);
+    BOOST_TEST(*matches[0] == (node{ "port", "80" }));
+    BOOST_TEST(*matches[1] == (node{ "port", "443" }));
+    BOOST_TEST((matches[0] == &root[1][2][1]));
+
+    BOOST_TEST(selector("(config server port)").select(root).size() == 1u);
+    BOOST_TEST(selector("(config * * port)").select(root).size() == 3u);
+    BOOST_TEST(selector("(config)").select(root).size() == 1u);
+    BOOST_TEST(selector("(server)").select(root).empty());
+    BOOST_TEST(selector("(config \"server\" name)").select(root).size() == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(stream_matches_nodes)
+{
+    const std::string_view queries[] = {
+        "(config server * port)", "(config * * port)", "(config server)", "(config)",
+        "(nope)", "(config server \"listen\" host)",
+    };
+    const auto root = parse(config);
+    for (auto query : queries)
+    {
+        BOOST_TEST_CONTEXT(query)
+        {
+            selector s(query);
+            std::vector<node> streamed;
+            s.scan(config, [&streamed](std::string_view text)
+            {
+                streamed.push_back(parse(text));
+            });
+
+            const auto matches = s.select(root);
+            BOOST_TEST_REQUIRE(streamed.size() == matches.size());
+            for (std::size_t i = 0; i < matches.size(); ++i)
+            {
+                BOOST_TEST(streamed[i] == *matches[i]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(stream_of_records)
+{
+    std::string input;
+    for (int i = 0; i < 1000; ++i)
+    {
+        input += "(rec (id " + std::to_string(i) + ") (\"a b\" (id skipped)) x)\n";
+    }
+    input += "top-level-atom";
+
+    int count = 0;
+    selector("(rec id)").scan(input, [&count](std::string_view text)
+    {
+        BOOST_TEST(parse(text) == (node{ "id", std::to_string(count) }));
+        ++count;
+    });
+    BOOST_TEST(count == 1000);
+}
+
+BOOST_AUTO_TEST_CASE(escaped_heads)
+{
+    selector s(R"(("a\"b" c))");
+    const std::string_view input = R"(("a\"b" (c 1) ("c" 2) (d 3)))";
+    BOOST_TEST(s.select(parse(input)).size() == 2u);
+    int count = 0;
+    s.scan(input, [&count](std::string_view) { ++count; });
+    BOOST_TEST(count == 2);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_queries)
+{
+    BOOST_CHECK_THROW(selector("()"), std::domain_error);
+    BOOST_CHECK_THROW(selector("config"), std::domain_error);
+    BOOST_CHECK_THROW(selector("(config (server))"), std::domain_error);
+    BOOST_CHECK_THROW(selector("(config) port"), std::domain_error);
+    BOOST_CHECK_THROW(selector("(config"), parse_error);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
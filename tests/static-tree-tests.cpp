@@ -0,0 +1,84 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/static_tree.hpp>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+BOOST_TEST_DONT_PRINT_LOG_VALUE(sexpr::tape_cursor)
+using namespace sexpr;
+
+
+namespace
+{
+constexpr std::string_view pattern_text = R"((define (f "x\ty") () "a\"b"))";
+constexpr auto pattern_extent = detail::static_extent_of(pattern_text);
+constexpr static_tree<pattern_extent.entries, pattern_extent.atoms> pattern(pattern_text);
+
+static_assert(pattern_extent.entries == 10, "");
+static_assert(pattern_extent.atoms == 13, "");
+static_assert(pattern.root().size() == 4, "");
+static_assert(pattern.root()[1][1].get_string() == "x\ty", "");
+static_assert(pattern.root()[2].is_list() && pattern.root()[2].empty(), "");
+static_assert(pattern.root().back().get_string() == "a\"b", "");
+static_assert(pattern.root() == static_tree<10, 13>(pattern_text).root(), "");
+}
+
+
+BOOST_AUTO_TEST_SUITE(static_tree_tests)
+
+
+BOOST_AUTO_TEST_CASE(literal)
+{
+    auto t = SEXPR_LITERAL("(a (b c) \"d e\")");
+    BOOST_TEST(t == (node{ "a",{ "b", "c" }, "d e" }));
+    BOOST_TEST(t != (node{ "a",{ "b", "c" }, "d" }));
+    BOOST_TEST(to_node(t) == (node{ "a",{ "b", "c" }, "d e" }));
+    BOOST_TEST(t == parse_tape("(a (b c) \"d e\")").root());
+}
+
+BOOST_AUTO_TEST_CASE(static_storage)
+{
+    auto get = []() { return SEXPR_LITERAL("(foo bar)"); };
+    BOOST_TEST((get().entries() == get().entries()));
+    BOOST_TEST(get()[1].get_string() == "bar");
+}
+
+BOOST_AUTO_TEST_CASE(matches_parser)
+{
+    const std::string_view inputs[] = {
+        "atom", "\"\"", "()", "(())", "  ( a  (b) ( ) \"\\\\\" )  ", pattern_text,
+    };
+    for (auto input : inputs)
+    {
+        BOOST_TEST_CONTEXT(input)
+        {
+            detail::static_extent extent;
+            detail::static_parse(input, extent);
+            std::vector<tape_entry> entries(extent.entries);
+            std::string atoms(extent.atoms + 1, '\0');
+            detail::static_tape_writer writer(entries.data(), atoms.data());
+            detail::static_parse(input, writer);
+            BOOST_TEST(tape_cursor(entries.data(), atoms.data(), 0) == parse(input));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(syntax_errors)
+{
+    detail::static_extent extent;
+    BOOST_CHECK_THROW(detail::static_parse("", extent), parse_error);
+    BOOST_CHECK_THROW(detail::static_parse("(a", extent), parse_error);
+    BOOST_CHECK_THROW(detail::static_parse("a)", extent), parse_error);
+    BOOST_CHECK_THROW(detail::static_parse("(a) b", extent), parse_error);
+    BOOST_CHECK_THROW(detail::static_parse("\"a\\\"", extent), parse_error);
+    BOOST_CHECK_THROW((static_tree<1, 2>("a")), std::domain_error);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
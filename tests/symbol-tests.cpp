@@ -0,0 +1,122 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/symbol.hpp>
+#include <sexpr-cpp/parser.hpp>
+
+#include <thread>
+#include <unordered_set>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+using namespace sexpr;
+
+
+BOOST_AUTO_TEST_SUITE(symbol_tests)
+
+
+BOOST_AUTO_TEST_CASE(interning)
+{
+    symbol a("foo", 3);
+    symbol b(std::string("foo"));
+    BOOST_TEST(a == b);
+    BOOST_TEST((a.data() == b.data()));
+    BOOST_TEST(a.table() == &symbol_table::global());
+    BOOST_TEST(a.c_str()[3] == '\0');
+    BOOST_TEST(a.hash() == std::hash<std::string_view>()("foo"));
+    BOOST_TEST(std::hash<symbol>()(a) == a.hash());
+    BOOST_TEST(a != symbol("bar", 3));
+}
+
+BOOST_AUTO_TEST_CASE(empty_symbol)
+{
+    symbol s;
+    BOOST_TEST(s.empty());
+    BOOST_TEST(s.size() == 0u);
+    BOOST_TEST(s.table() == nullptr);
+    BOOST_TEST(s == symbol("", 0));
+
+    symbol foo("foo", 3);
+    foo.clear();
+    BOOST_TEST(foo == s);
+}
+
+BOOST_AUTO_TEST_CASE(separate_tables)
+{
+    symbol_table table;
+    symbol a("qux", table);
+    symbol b("qux", table);
+    symbol c(std::string_view("qux"));
+    BOOST_TEST(table.size() == 1u);
+    BOOST_TEST((a.data() == b.data()));
+    BOOST_TEST((a.data() != c.data()));
+    BOOST_TEST(a == c);
+    BOOST_TEST(a.compare(c) == 0);
+    BOOST_TEST(table.find("qux") != nullptr);
+    BOOST_TEST(table.find("quux") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(ordering)
+{
+    symbol a("abc", 3);
+    symbol b("abd", 3);
+    BOOST_TEST(a < b);
+    BOOST_TEST(!(b < a));
+    BOOST_TEST(symbol_traits::compare(a, b) < 0);
+    BOOST_TEST(symbol_traits::compare(b, a) > 0);
+    BOOST_TEST(symbol_traits::compare(a, a) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(symbol_nodes)
+{
+    symbol_node n{ "define",{ "x", "y" }, "x" };
+    auto parsed = parse<symbol_node>("(define (x y) x)");
+    BOOST_TEST(n == parsed);
+    BOOST_TEST((parsed[0].get_string().data() == n[0].get_string().data()));
+    BOOST_TEST((parsed[2].get_string().data() == parsed[1][0].get_string().data()));
+    BOOST_TEST(parsed < (symbol_node{ "define",{ "x", "z" } }));
+
+    auto escaped = parse<symbol_node>(R"("a\tb")");
+    BOOST_TEST(escaped.get_string() == "a\tb");
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_interning)
+{
+    symbol_table table;
+    constexpr int symbols = 1000;
+    std::vector<std::vector<symbol>> results(4);
+    std::vector<std::thread> threads;
+    for (auto &result : results)
+    {
+        threads.emplace_back([&table, &result]
+        {
+            for (int i = 0; i < symbols; ++i)
+            {
+                result.emplace_back(std::to_string(i), table);
+            }
+        });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    BOOST_TEST(table.size() == static_cast<std::size_t>(symbols));
+    for (auto &result : results)
+    {
+        for (int i = 0; i < symbols; ++i)
+        {
+            BOOST_TEST_REQUIRE((result[i].data() == results[0][i].data()));
+        }
+    }
+    std::unordered_set<symbol> distinct(results[0].begin(), results[0].end());
+    BOOST_TEST(distinct.size() == static_cast<std::size_t>(symbols));
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,134 @@
+// Copyright 2017 Henrik Steffen Gaßmann
+//
+// Licensed under the MIT License.
+// See LICENSE file in the project root for full license information.
+//
+//#include "precompiled.hpp"
+#include <sexpr-cpp/tape.hpp>
+
+#include <iterator>
+
+#include "data-helpers.hpp"
+#include "boost-unit-test.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::type_info)
+BOOST_TEST_DONT_PRINT_LOG_VALUE(sexpr::tape_cursor)
+BOOST_TEST_DONT_PRINT_LOG_VALUE(sexpr::node_type)
+using namespace sexpr;
+
+
+BOOST_AUTO_TEST_SUITE(tape_tests)
+
+
+BOOST_AUTO_TEST_CASE(default_is_empty_list)
+{
+    tape t;
+    BOOST_TEST(t.root().is_list());
+    BOOST_TEST(t.root().empty());
+    BOOST_TEST(t.root().size() == 0u);
+    BOOST_TEST((t.root().begin() == t.root().end()));
+}
+
+BOOST_AUTO_TEST_CASE(atom_root)
+{
+    tape t(node("foo"));
+    auto r = t.root();
+    BOOST_TEST(r.is_string());
+    BOOST_TEST(r.size() == 1u);
+    BOOST_TEST(r.get_string() == "foo");
+    BOOST_CHECK_THROW(r.begin(), std::domain_error);
+    BOOST_CHECK_THROW(r[0], std::domain_error);
+    BOOST_CHECK_THROW(r.back(), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(read_interface)
+{
+    node n{ "foo",{ "bar",{ "baz" } },{}, "qux" };
+    tape t(n);
+    auto r = t.root();
+
+    BOOST_TEST_REQUIRE(r.is_list());
+    BOOST_TEST(r.size() == 4u);
+    BOOST_TEST(std::distance(r.begin(), r.end()) == 4);
+    BOOST_TEST(r[0].get_string() == "foo");
+    BOOST_TEST(r[1].size() == 2u);
+    BOOST_TEST(r[1][1][0].get_string() == "baz");
+    BOOST_TEST(r[2].empty());
+    BOOST_TEST(r[3].get_string() == "qux");
+    BOOST_TEST(r.front().get_string() == "foo");
+    BOOST_TEST(r.back().get_string() == "qux");
+    BOOST_TEST(r[1].back()[0].get_string() == "baz");
+    BOOST_TEST(r.begin()->get_string() == "foo");
+    BOOST_CHECK_THROW(r.at(4), std::out_of_range);
+    BOOST_CHECK_THROW(r.get_string(), std::domain_error);
+
+    std::vector<node_type> types;
+    for (auto child : r)
+    {
+        types.push_back(child.which());
+    }
+    BOOST_TEST((types == std::vector<node_type>{ node_type::string,
+        node_type::list, node_type::list, node_type::string }));
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    node n{ "foo",{ "bar",{ "baz", "" } },{},{ { { "deep" } } } };
+    tape t(n);
+    BOOST_TEST(t.root() == n);
+    BOOST_TEST(n == t.root());
+    BOOST_TEST(to_node(t.root()) == n);
+    BOOST_TEST(to_node(t.root()[1]) == n[1]);
+
+    // one entry per atom and two per list
+    BOOST_TEST(t.entries().size() == 19u);
+    BOOST_TEST(t.atoms() == "foobarbazdeep");
+}
+
+BOOST_AUTO_TEST_CASE(inequality)
+{
+    tape t(node{ "foo",{ "bar" } });
+    BOOST_TEST(t.root() != (node{ "foo",{ "baz" } }));
+    BOOST_TEST(t.root() != (node{ "foo", "bar" }));
+    BOOST_TEST(t.root() != (node{ "foo",{ "bar" }, "baz" }));
+    BOOST_TEST(t.root() != node("foo"));
+}
+
+BOOST_AUTO_TEST_CASE(cursor_equality)
+{
+    tape a(node{ "x",{ "foo", "bar" } });
+    tape b(node{ "foo", "bar" });
+    BOOST_TEST(a.root()[1] == b.root());
+    BOOST_TEST(a.root() != b.root());
+    BOOST_TEST(a.root()[0] != b.root()[0]);
+}
+
+BOOST_AUTO_TEST_CASE(parse_directly)
+{
+    auto t = parse_tape(R"((foo "a\nb" (bar) ()))");
+    BOOST_TEST(t.root() == (node{ "foo", "a\nb",{ "bar" },{} }));
+    BOOST_CHECK_THROW(parse_tape("(foo"), parse_error);
+    BOOST_CHECK_THROW(parse_tape("foo bar"), parse_error);
+    BOOST_CHECK_THROW(parse_tape(""), parse_error);
+}
+
+BOOST_AUTO_TEST_CASE(deep_nesting)
+{
+    constexpr std::size_t depth = 100000;
+    std::string text(depth, '(');
+    text.append(depth, ')');
+    auto t = parse_tape(text);
+
+    auto c = t.root();
+    std::size_t levels = 1;
+    while (!c.empty())
+    {
+        c = c.front();
+        ++levels;
+    }
+    BOOST_TEST(levels == depth);
+    BOOST_TEST(t.root() == t.root());
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()